@@ -4,6 +4,9 @@ struct file;
 struct inode;
 struct pipe;
 struct proc;
+struct queue;
+struct mlfqpolicy;
+struct schedstat;
 struct rtcdate;
 struct spinlock;
 struct sleeplock;
@@ -68,6 +71,8 @@ char*           kalloc(void);
 void            kfree(char*);
 void            kinit1(void*, void*);
 void            kinit2(void*, void*);
+void            kincref(char*);
+int             krefcount(char*);
 
 // kbd.c
 void            kbdintr(void);
@@ -78,6 +83,10 @@ int             lapicid(void);
 extern volatile uint*    lapic;
 void            lapiceoi(void);
 void            lapicinit(void);
+void            lapicipi(int, int);
+void            lapiconeshot(uint);
+void            lapicperiodic(void);
+uint            lapicwake(void);
 void            lapicstartap(uchar, uint);
 void            microdelay(int);
 
@@ -160,7 +169,10 @@ void            syscall(void);
 void            timerinit(void);
 
 // trap.c
+void            clockadvance(uint);
+uint            clockdeadline(void);
 void            idtinit(void);
+void            sleepuntil(uint);
 extern uint     ticks;
 void            tvinit(void);
 extern struct spinlock tickslock;
@@ -181,6 +193,9 @@ void            freevm(pde_t*);
 void            inituvm(pde_t*, char*, uint);
 int             loaduvm(pde_t*, char*, struct inode*, uint, uint);
 pde_t*          copyuvm(pde_t*, uint);
+int             cowfault(pde_t*, uint);
+int             lazyfault(pde_t*, uint, uint);
+int             uvmtouch(pde_t*, uint, uint, uint);
 void            switchuvm(struct proc*);
 void            switchkvm(void);
 int             copyout(pde_t*, uint, void*, uint);
@@ -198,14 +213,24 @@ void            setPriority(int pid, int priority);
 void            mycall(void);
 
 //queue.c
-int            enqueue(int, int);
-int             dequeue(int);
-int             is_full(int);
-int             is_empty(int);
-void            qinit(void);
+int             enqueue(struct queue*, struct proc*);
+struct proc*    dequeue(struct queue*);
+void            qremove(struct queue*, struct proc*);
+void            qinsertbefore(struct queue*, struct proc*, struct proc*);
+void            qsplice(struct queue*, struct queue*);
+int             is_empty(struct queue*);
+void            qinit(struct queue*);
 void            printQinfo(int);
 
 
-void            schedulerLock(int);
-void            schedulerUnlock(int);
-void            priority_boosting(void);
\ No newline at end of file
+int             setReservation(int, int, int);
+int             setAffinity(int, int);
+int             yield_to(int);
+void            inheritpriority(struct sleeplock*);
+void            disinheritpriority(struct proc*);
+void            rtreplenish(void);
+uint            rtdeadline(void);
+void            wakecpu(int);
+int             setMLFQPolicy(struct mlfqpolicy*, struct mlfqpolicy*);
+int             getSchedStat(int, struct schedstat*);
+void            mlfq_tick(uint);
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "param.h"
 #include "memlayout.h"
 #include "mmu.h"
+#include "mlfq.h"
 #include "proc.h"
 #include "defs.h"
 #include "x86.h"
@@ -0,0 +1,84 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+// Fork benchmark.
+//   forkbench [n] [kb]
+// Times n rounds (default 100) of fork and wait, with the child doing
+// nothing but exit, with it exec'ing a program that exits at once,
+// and with it writing to every page of the heap before it exits.
+// Runs once with no heap and once after growing and touching kb
+// kilobytes of it (default 1024), and prints the ticks each took.
+// With copy-on-write fork, only the last run grows with the heap.
+
+#define PGSIZE 4096
+
+char *heap;
+int heapsize;
+char *self;
+
+int
+rounds(int n, int mode)
+{
+  char *argv[3];
+  int i, j, t0, pid;
+
+  t0 = uptime();
+  for(i = 0; i < n; i++){
+    pid = fork();
+    if(pid < 0){
+      printf(2, "forkbench: fork failed\n");
+      exit();
+    }
+    if(pid == 0){
+      if(mode == 1){
+        argv[0] = self;
+        argv[1] = "-x";
+        argv[2] = 0;
+        exec(self, argv);
+        printf(2, "forkbench: exec %s failed\n", self);
+      } else if(mode == 2){
+        for(j = 0; j < heapsize; j += PGSIZE)
+          heap[j] = j;
+      }
+      exit();
+    }
+    wait();
+  }
+  return uptime() - t0;
+}
+
+void
+run(int n)
+{
+  printf(1, "%d KB\t%d\t%d\t%d\n", heapsize / 1024,
+         rounds(n, 0), rounds(n, 1), rounds(n, 2));
+}
+
+int
+main(int argc, char *argv[])
+{
+  int n, kb, i;
+
+  if(argc > 1 && strcmp(argv[1], "-x") == 0)
+    exit();
+  self = argv[0];
+  n = argc > 1 ? atoi(argv[1]) : 100;
+  kb = argc > 2 ? atoi(argv[2]) : 1024;
+  if(n < 1 || kb < 0){
+    printf(2, "usage: forkbench [n] [kb]\n");
+    exit();
+  }
+  printf(1, "%d forks each (ticks)\n", n);
+  printf(1, "heap\texit\texec\twrite heap\n");
+  run(n);
+  if((heap = sbrk(kb * 1024)) == (char*)-1){
+    printf(2, "forkbench: sbrk failed\n");
+    exit();
+  }
+  heapsize = kb * 1024;
+  for(i = 0; i < heapsize; i += PGSIZE)
+    heap[i] = 1;
+  run(n);
+  exit();
+}
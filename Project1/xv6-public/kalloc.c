@@ -21,6 +21,9 @@ struct {
   struct spinlock lock;
   int use_lock;
   struct run *freelist;
+  // Number of page tables mapping each physical page, more than one
+  // for pages shared copy-on-write after fork (see copyuvm).
+  ushort ref[PHYSTOP / PGSIZE];
 } kmem;
 
 // Initialization happens in two phases.
@@ -48,22 +51,37 @@ freerange(void *vstart, void *vend)
 {
   char *p;
   p = (char*)PGROUNDUP((uint)vstart);
-  for(; p + PGSIZE <= (char*)vend; p += PGSIZE)
+  for(; p + PGSIZE <= (char*)vend; p += PGSIZE){
+    kmem.ref[V2P(p) / PGSIZE] = 1;
     kfree(p);
+  }
 }
 //PAGEBREAK: 21
 // Free the page of physical memory pointed at by v,
 // which normally should have been returned by a
 // call to kalloc().  (The exception is when
 // initializing the allocator; see kinit above.)
+// A page shared copy-on-write is only freed once the
+// last page table mapping it lets go of it.
 void
 kfree(char *v)
 {
   struct run *r;
+  int ref;
 
   if((uint)v % PGSIZE || v < end || V2P(v) >= PHYSTOP)
     panic("kfree");
 
+  if(kmem.use_lock)
+    acquire(&kmem.lock);
+  if(kmem.ref[V2P(v) / PGSIZE] == 0)
+    panic("kfree: not allocated");
+  ref = --kmem.ref[V2P(v) / PGSIZE];
+  if(kmem.use_lock)
+    release(&kmem.lock);
+  if(ref > 0)
+    return;
+
   // Fill with junk to catch dangling refs.
   memset(v, 1, PGSIZE);
 
@@ -87,10 +105,36 @@ kalloc(void)
   if(kmem.use_lock)
     acquire(&kmem.lock);
   r = kmem.freelist;
-  if(r)
+  if(r){
     kmem.freelist = r->next;
+    kmem.ref[V2P(r) / PGSIZE] = 1;
+  }
   if(kmem.use_lock)
     release(&kmem.lock);
   return (char*)r;
 }
 
+// Record one more page table mapping the page at v.
+void
+kincref(char *v)
+{
+  if(kmem.use_lock)
+    acquire(&kmem.lock);
+  kmem.ref[V2P(v) / PGSIZE]++;
+  if(kmem.use_lock)
+    release(&kmem.lock);
+}
+
+// Number of page tables mapping the page at v.
+int
+krefcount(char *v)
+{
+  int ref;
+
+  if(kmem.use_lock)
+    acquire(&kmem.lock);
+  ref = kmem.ref[V2P(v) / PGSIZE];
+  if(kmem.use_lock)
+    release(&kmem.lock);
+  return ref;
+}
@@ -32,6 +32,7 @@
 #define TIMER   (0x0320/4)   // Local Vector Table 0 (TIMER)
   #define X1         0x0000000B   // divide counts by 1
   #define PERIODIC   0x00020000   // Periodic
+  #define TICKCOUNT  10000000     // Timer counts per tick
 #define PCINT   (0x0340/4)   // Performance Counter LVT
 #define LINT0   (0x0350/4)   // Local Vector Table 1 (LINT0)
 #define LINT1   (0x0360/4)   // Local Vector Table 2 (LINT1)
@@ -66,7 +67,7 @@ lapicinit(void)
   // TICR would be calibrated using an external time source.
   lapicw(TDCR, X1);
   lapicw(TIMER, PERIODIC | (T_IRQ0 + IRQ_TIMER));
-  lapicw(TICR, 10000000);
+  lapicw(TICR, TICKCOUNT);
 
   // Disable logical interrupt lines.
   lapicw(LINT0, MASKED);
@@ -113,6 +114,75 @@ lapiceoi(void)
     lapicw(EOI, 0);
 }
 
+// Send interrupt vector to the cpu with the given APIC ID.
+// Caller must have interrupts disabled.
+void
+lapicipi(int apicid, int vector)
+{
+  lapicw(ICRHI, apicid<<24);
+  lapicw(ICRLO, FIXED | ASSERT | vector);
+  while(lapic[ICRLO] & DELIVS)
+    ;
+}
+
+// Stop the periodic tick and interrupt once, at the n-th tick boundary
+// from now (n == 0: as late as the counter allows). Counting from the
+// current tick's remaining count keeps the clock aligned to the ticks.
+void
+lapiconeshot(uint n)
+{
+  uint left, max;
+
+  if(!lapic)
+    return;
+  left = lapic[TCCR];
+  if(left == 0)
+    left = TICKCOUNT;
+  max = (0xFFFFFFFF - left) / TICKCOUNT + 1;
+  if(n == 0 || n > max)
+    n = max;
+  lapicw(TIMER, T_IRQ0 + IRQ_TIMER);
+  lapicw(TICR, left + (n-1) * TICKCOUNT);
+}
+
+// Called after waking from lapiconeshot(). Returns the number of tick
+// boundaries passed since then. If the one-shot hasn't fired yet, re-arm
+// it for the next boundary; the timer interrupt there calls
+// lapicperiodic(), so no partial tick is lost.
+uint
+lapicwake(void)
+{
+  uint init, cur, left, passed;
+
+  if(!lapic)
+    return 0;
+  init = lapic[TICR];
+  cur = lapic[TCCR];
+  left = init % TICKCOUNT;
+  if(left == 0)
+    left = TICKCOUNT;
+  if(cur == 0){
+    lapicperiodic();
+    return (init - left) / TICKCOUNT + 1;
+  }
+  if(init - cur < left)
+    passed = 0;
+  else
+    passed = 1 + (init - cur - left) / TICKCOUNT;
+  lapicw(TICR, left + passed * TICKCOUNT - (init - cur));
+  return passed;
+}
+
+// Go back to the periodic tick if the timer is in one-shot mode.
+void
+lapicperiodic(void)
+{
+  if(!lapic || (lapic[TIMER] & PERIODIC))
+    return;
+  lapicw(TIMER, PERIODIC | (T_IRQ0 + IRQ_TIMER));
+  lapicw(TICR, TICKCOUNT);
+}
+
 // Spin for a given number of microseconds.
 // On real hardware would want to tune this dynamically.
 void
@@ -3,6 +3,7 @@
 #include "param.h"
 #include "memlayout.h"
 #include "mmu.h"
+#include "mlfq.h"
 #include "proc.h"
 #include "x86.h"
 
@@ -5,6 +5,7 @@
 #include "defs.h"
 #include "param.h"
 #include "mmu.h"
+#include "mlfq.h"
 #include "proc.h"
 #include "x86.h"
 #include "traps.h"
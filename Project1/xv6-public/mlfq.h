@@ -0,0 +1,32 @@
+// MLFQ scheduling policy, read and swapped with setMLFQPolicy().
+#define MLFQ_MAXLEVEL 8   // most levels a policy can have
+
+// What happens when a process uses up its quantum above the last level.
+// On the last level it always stays put and loses one priority instead.
+#define MLFQ_DEMOTE_STEP   0  // drop one level
+#define MLFQ_DEMOTE_BOTTOM 1  // drop straight to the last level
+#define MLFQ_DEMOTE_NONE   2  // stay; levels act as fixed priorities
+
+// How the last level shares the cpu among its processes.
+#define MLFQ_LAST_PRIORITY 0  // lowest priority first, round robin within one
+#define MLFQ_LAST_STRIDE   1  // stride scheduling, tickets set by priority
+
+struct mlfqpolicy {
+  int nlevel;                  // levels in use, 1..MLFQ_MAXLEVEL
+  int quantum[MLFQ_MAXLEVEL];  // ticks a process gets at each level
+  int boostperiod;             // ticks between priority boosts, 0: never
+  int demote;                  // MLFQ_DEMOTE_*
+  int lastlevel;               // MLFQ_LAST_*
+};
+
+// Scheduler counters, per process and system-wide, read with
+// getSchedStat(). Run-queue waits are the ticks from becoming RUNNABLE
+// to being picked, bucketed by powers of two: 0, 1, 2-3, 4-7, ..., 64+.
+#define SCHED_NBUCKET 8
+
+struct schedstat {
+  uint wait[SCHED_NBUCKET];    // picks by run-queue wait
+  uint slices[MLFQ_MAXLEVEL];  // time slices run at each level
+  uint demotions;              // quanta used up that cost a level
+  uint boosts;                 // times lifted back to L0 by a boost
+};
@@ -0,0 +1,33 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+// Show or set which cpus a process may run on.
+//   pin pid          print its affinity mask
+//   pin pid mask     let it run only on the cpus in mask, bit i for cpu i
+
+int
+main(int argc, char *argv[])
+{
+  int pid, mask, old;
+
+  if(argc < 2 || argc > 3){
+    printf(2, "usage: pin pid [mask]\n");
+    exit();
+  }
+  pid = atoi(argv[1]);
+  mask = argc == 3 ? atoi(argv[2]) : 0;
+  if(argc == 3 && mask == 0){
+    printf(2, "pin: empty mask\n");
+    exit();
+  }
+  if((old = setAffinity(pid, mask)) < 0){
+    printf(2, "pin: cannot set affinity of %d\n", pid);
+    exit();
+  }
+  if(argc == 3)
+    printf(1, "pid %d: mask %x -> %x\n", pid, old, mask);
+  else
+    printf(1, "pid %d: mask %x\n", pid, old);
+  exit();
+}
@@ -0,0 +1,77 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+// Context-switch latency benchmark.
+//   pingpong [n]
+// A parent and child pinned to cpu 0 pass the cpu back and forth n
+// times (default 50000) three ways: a byte bounced over two pipes, both
+// calling yield(), which goes through scheduler(), and both calling
+// yield_to() on the other, which switches directly.
+
+enum { PIPE, YIELD, YIELDTO };
+static char *modes[] = {
+  [PIPE]    "pipe",
+  [YIELD]   "yield",
+  [YIELDTO] "yield_to",
+};
+
+void
+run(int mode, int n)
+{
+  int p1[2], p2[2], pid, parent, partner, i, t0, t1;
+  char c;
+
+  if(pipe(p1) < 0 || pipe(p2) < 0){
+    printf(2, "pingpong: pipe failed\n");
+    exit();
+  }
+  parent = getpid();
+  t0 = uptime();
+  if((pid = fork()) < 0){
+    printf(2, "pingpong: fork failed\n");
+    exit();
+  }
+  partner = pid ? pid : parent;
+  for(i = 0; i < n; i++){
+    switch(mode){
+    case PIPE:
+      if(pid){
+        write(p1[1], "x", 1);
+        read(p2[0], &c, 1);
+      } else {
+        read(p1[0], &c, 1);
+        write(p2[1], "x", 1);
+      }
+      break;
+    case YIELD:
+      yield();
+      break;
+    case YIELDTO:
+      yield_to(partner);
+      break;
+    }
+  }
+  if(pid == 0)
+    exit();
+  wait();
+  t1 = uptime();
+  close(p1[0]);
+  close(p1[1]);
+  close(p2[0]);
+  close(p2[1]);
+  printf(1, "%s\t%d round trips in %d ticks\n", modes[mode], n, t1 - t0);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int n;
+
+  n = argc > 1 ? atoi(argv[1]) : 50000;
+  setAffinity(getpid(), 1);
+  run(PIPE, n);
+  run(YIELD, n);
+  run(YIELDTO, n);
+  exit();
+}
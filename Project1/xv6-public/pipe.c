@@ -2,6 +2,7 @@
 #include "defs.h"
 #include "param.h"
 #include "mmu.h"
+#include "mlfq.h"
 #include "proc.h"
 #include "fs.h"
 #include "spinlock.h"
@@ -0,0 +1,73 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "mlfq.h"
+
+// Show or replace the kernel's MLFQ policy.
+//   policy                                  print the policy in force
+//   policy boost step|bottom|none [stride] q0 [q1 ...]
+//                                           install a new one; stride
+//                                           makes the last level share
+//                                           the cpu by priority tickets
+
+static char *demotes[] = {
+  [MLFQ_DEMOTE_STEP]   "step",
+  [MLFQ_DEMOTE_BOTTOM] "bottom",
+  [MLFQ_DEMOTE_NONE]   "none",
+};
+
+void
+print(struct mlfqpolicy *pol)
+{
+  int i;
+
+  printf(1, "levels %d, boost every %d ticks, demote %s, last level by %s\n",
+         pol->nlevel, pol->boostperiod, demotes[pol->demote],
+         pol->lastlevel == MLFQ_LAST_STRIDE ? "stride" : "priority");
+  for(i = 0; i < pol->nlevel; i++)
+    printf(1, "L%d: quantum %d\n", i, pol->quantum[i]);
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct mlfqpolicy pol, old;
+  int i, q;
+
+  if(argc == 1){
+    if(setMLFQPolicy(0, &old) < 0){
+      printf(2, "policy: cannot read policy\n");
+      exit();
+    }
+    print(&old);
+    exit();
+  }
+  q = 3;
+  if(argc > 3 && strcmp(argv[3], "stride") == 0)
+    q = 4;
+  if(argc <= q || argc - q > MLFQ_MAXLEVEL){
+    printf(2, "usage: policy [boost step|bottom|none [stride] q0 [q1 ...]]\n");
+    exit();
+  }
+
+  memset(&pol, 0, sizeof(pol));
+  pol.boostperiod = atoi(argv[1]);
+  pol.demote = -1;
+  for(i = MLFQ_DEMOTE_STEP; i <= MLFQ_DEMOTE_NONE; i++)
+    if(strcmp(argv[2], demotes[i]) == 0)
+      pol.demote = i;
+  pol.lastlevel = q == 4 ? MLFQ_LAST_STRIDE : MLFQ_LAST_PRIORITY;
+  pol.nlevel = argc - q;
+  for(i = 0; i < pol.nlevel; i++)
+    pol.quantum[i] = atoi(argv[q + i]);
+
+  if(setMLFQPolicy(&pol, &old) < 0){
+    printf(2, "policy: invalid policy\n");
+    exit();
+  }
+  printf(1, "old policy:\n");
+  print(&old);
+  printf(1, "new policy:\n");
+  print(&pol);
+  exit();
+}
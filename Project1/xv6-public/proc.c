@@ -4,14 +4,32 @@
 #include "memlayout.h"
 #include "mmu.h"
 #include "x86.h"
+#include "mlfq.h"
 #include "proc.h"
 #include "queue.h"
 #include "spinlock.h"
+#include "sleeplock.h"
+#include "traps.h"
+
+// Process slots live in kalloc'd pages chained through next, and the
+// table grows by a page whenever allocproc() finds no free slot. A page
+// whose slots are all UNUSED again is given back when the last one is
+// freed, as long as a page's worth of other slots stays free, so the
+// table shrinks after a burst of forks without thrashing at the edge.
+struct procpage;
+#define NPROCPAGE ((PGSIZE - sizeof(struct procpage *) - sizeof(int)) / sizeof(struct proc))
+struct procpage
+{
+  struct procpage *next;
+  int nused; // slots not UNUSED
+  struct proc proc[NPROCPAGE];
+};
 
 struct
 {
   struct spinlock lock;
-  struct proc proc[NPROC];
+  struct procpage *pages;
+  Queue free; // UNUSED slots, linked through qnext like a run queue
 } ptable;
 
 static struct proc *initproc;
@@ -20,18 +38,371 @@ int nextpid = 1;
 extern void forkret(void);
 extern void trapret(void);
 
+// Scheduling policy in force; setMLFQPolicy() swaps it under ptable.lock.
+// The default is the original 3 levels with 2n+4 tick quanta.
+static struct mlfqpolicy policy = {
+    .nlevel = 3,
+    .quantum = {4, 6, 8},
+    .boostperiod = 100,
+    .demote = MLFQ_DEMOTE_STEP,
+    .lastlevel = MLFQ_LAST_PRIORITY,
+};
+
+// Per-CPU MLFQ run queues, indexed like cpus[]. A cpu picks only from
+// its own queues and looks at a peer's only when it has nothing RUNNABLE.
+// Only RUNNABLE processes are queued: real-time processes with budget
+// left come first, then every MLFQ level but the last has one queue and
+// the last has one per priority, so the pick is the head of the lowest
+// non-empty queue no matter how many processes are asleep. Real-time
+// processes that used up their budget wait on throttled, outside the
+// pick, until rtreplenish() refills them at their next period.
+// With MLFQ_LAST_STRIDE the last level is instead one queue kept sorted
+// by stride pass, so the pick is still its head.
+// The queues link process table slots, so ptable.lock still guards them.
+#define NPRIO 4                         // last-level priorities, 0 runs first
+#define RTQ 0                           // real-time queue
+#define NRUNQ (MLFQ_MAXLEVEL + NPRIO) // RTQ, upper levels, last by priority
+struct runq
+{
+  Queue q[NRUNQ];
+  Queue throttled; // real-time processes out of budget
+  uint nonempty;   // bit i set while q[i] has entries
+  int nrunnable;   // processes on q[], i.e. pickable on this cpu
+  uint boostticks; // this cpu's timer ticks since its last boost
+  uint boostepoch; // boosts so far; see boostsync()
+  uint vpass;      // pass of the last stride pick, where newcomers start
+};
+
+// Stride scheduling on the last level: priority n holds 1 << (NPRIO-1-n)
+// tickets and each slice advances a process's pass by STRIDE1 / tickets,
+// so priority 0 gets 8 times the cpu of priority 3.
+#define STRIDE1 1024
+#define STRIDEQ MLFQ_MAXLEVEL // the one last-level queue in stride mode
+
+// A process that ran this few ticks ago still has a warm cache where it
+// ran, so idle cpus steal colder ones first.
+#define CACHEHOT 2
+
+// Real-time reservations may use at most this share, in percent, of
+// each cpu, so MLFQ processes always keep the rest of the machine.
+// Shares are added up in RTUNIT-ths of a percent.
+#define RTMAXSHARE 50
+#define RTUNIT 1024
+static uint rtwake = ~0; // earliest rtnext on any throttled queue
+static struct runq runq[NCPU];
+static struct schedstat sysstat; // every process's counters summed, since boot
+
 static void wakeup1(void *chan);
-int pick_in_mlfq();
-void priority_boosting();
-int isLocked = 0;           // SCHEDULER의 LOCK 유무
-int pickedProcessIndex = 0; // queue에서 뽑은 process의 인덱스 또는 현재 도는 proc_index
-int noSuchPid = 1;          // 그런 PID 또 없습니다~
+static void idle(struct cpu *c);
+static struct proc *pick_in_mlfq(struct runq *rq);
+static struct proc *steal(struct runq *rq);
+static void priority_boosting(struct runq *rq);
+int noSuchPid = 1; // 그런 PID 또 없습니다~
 extern uint ticks;
 void printProcessInfo(struct proc *p);
 void pinit(void)
 {
   initlock(&ptable.lock, "ptable");
-  qinit();
+  qinit(&ptable.free);
+  for (int i = 0; i < NCPU; i++)
+  {
+    for (int j = 0; j < NRUNQ; j++)
+      qinit(&runq[i].q[j]);
+    qinit(&runq[i].throttled);
+  }
+}
+
+// Index of the cpu in mask with the fewest RUNNABLE processes, or
+// cpu 0 if mask names none. New processes start there; idle cpus
+// steal to even out the rest.
+static int
+leastloaded(uint mask)
+{
+  int i, best = -1;
+
+  for (i = 0; i < ncpu; i++)
+    if ((mask & (1 << i)) && (best < 0 || runq[i].nrunnable < runq[best].nrunnable))
+      best = i;
+  return best < 0 ? 0 : best;
+}
+
+// p is on the last level and that level is stride scheduled.
+static int
+stridden(struct proc *p)
+{
+  return p->rtperiod == 0 && policy.lastlevel == MLFQ_LAST_STRIDE &&
+         p->level >= policy.nlevel - 1;
+}
+
+// Apply the boosts p's cpu has done since p last looked. Boosting only
+// splices the queues and bumps the cpu's epoch; each process resets its
+// own level, priority and quantum here the next time the scheduler
+// looks at it, queued or not. Caller holds ptable.lock.
+static void
+boostsync(struct proc *p)
+{
+  uint epoch = runq[p->cpu].boostepoch;
+
+  if (p->boostepoch == epoch)
+    return;
+  p->boostepoch = epoch;
+  if (p->level != 0)
+  {
+    p->stat.boosts++;
+    sysstat.boosts++;
+  }
+  p->inherited = 0;   // 빌린 priority보다 boost가 낫다.
+  p->timequantum = 0; // timequnatum 0으로 할당하고
+  p->level = 0;       // level도 다시 0으로 넣고
+  p->priority = 3;    // priority도 다시 3으로 세팅
+}
+
+// Move p to cpu's run queues' bookkeeping; it must not be queued.
+// Boosts of the old cpu are applied first, the new cpu's are history.
+static void
+setcpu(struct proc *p, int cpu)
+{
+  boostsync(p);
+  p->cpu = cpu;
+  p->boostepoch = runq[cpu].boostepoch;
+}
+
+// Run queue p belongs on: RTQ if it is real-time, else its level, or
+// its priority's queue on the last level. Slots stay in pick order
+// whatever policy.nlevel is. Applies any boost p has missed first.
+static int
+qslot(struct proc *p)
+{
+  boostsync(p);
+  if (p->rtperiod)
+    return RTQ;
+  if (p->level < policy.nlevel - 1)
+    return 1 + p->level;
+  if (stridden(p))
+    return STRIDEQ;
+  return MLFQ_MAXLEVEL + p->priority;
+}
+
+// Real-time p is out of budget and waits on the throttled queue.
+static int
+throttled(struct proc *p)
+{
+  return p->rtperiod && p->rtleft == 0;
+}
+
+// Start a new period for real-time p if its current one is over.
+static void
+rtrefill(struct proc *p)
+{
+  if ((int)(ticks - p->rtnext) < 0)
+    return;
+  p->rtleft = p->rtbudget;
+  p->rtnext += p->rtperiod;
+  if ((int)(ticks - p->rtnext) >= 0) // slept through whole periods
+    p->rtnext = ticks + p->rtperiod;
+}
+
+// Take every RUNNABLE process off rq, in pick order, onto q.
+// The caller puts them back with rqinsert().
+static void
+rqdrain(struct runq *rq, Queue *q)
+{
+  struct proc *p;
+
+  for (int i = 0; i < NRUNQ; i++)
+    while ((p = dequeue(&rq->q[i])) != 0)
+      enqueue(q, p);
+  rq->nonempty = 0;
+  rq->nrunnable = 0;
+}
+
+// Queue RUNNABLE p on its cpu's run queue. Caller holds ptable.lock.
+static void
+rqinsert(struct proc *p)
+{
+  struct runq *rq = &runq[p->cpu];
+  struct proc *at;
+  int i = qslot(p);
+
+  if (throttled(p))
+  {
+    enqueue(&rq->throttled, p);
+    if (p->rtnext < rtwake) // cpu0 has to advance the clock by then
+    {
+      rtwake = p->rtnext;
+      if (cpus[0].idle)
+        wakecpu(0);
+    }
+    return;
+  }
+  if (stridden(p))
+  {
+    if ((int)(p->pass - rq->vpass) < 0) // 자는 동안의 몫은 쌓아두지 않는다.
+      p->pass = rq->vpass;
+    for (at = rq->q[i].head; at && (int)(at->pass - p->pass) <= 0; at = at->qnext)
+      ;
+    qinsertbefore(&rq->q[i], at, p); // pass 순서를 지킨다.
+  }
+  else
+    enqueue(&rq->q[i], p);
+  rq->nonempty |= 1 << i;
+  rq->nrunnable++;
+}
+
+// Mark p RUNNABLE and queue it; its run-queue wait starts now.
+// Caller holds ptable.lock.
+static void
+setrunnable(struct proc *p)
+{
+  p->state = RUNNABLE;
+  p->readyat = ticks;
+  if (!(p->affinity & (1 << p->cpu))) // 마지막 CPU에서 돌 수 없게 됐다면
+    setcpu(p, leastloaded(p->affinity));
+  if (p->rtperiod)
+    rtrefill(p);
+  rqinsert(p);
+}
+
+// Account for p being picked to run a time slice. Caller holds ptable.lock.
+static void
+countpick(struct proc *p)
+{
+  uint wait = ticks - p->readyat;
+  int b = 0;
+
+  while (b < SCHED_NBUCKET - 1 && wait >= (1 << b))
+    b++;
+  p->stat.wait[b]++;
+  sysstat.wait[b]++;
+  if (p->rtperiod)
+    return;
+  p->stat.slices[p->level]++;
+  sysstat.slices[p->level]++;
+}
+
+// Wake cpu from its halt in idle(). Caller has interrupts disabled.
+void
+wakecpu(int cpu)
+{
+  cpus[cpu].idle = 0;
+  if (&cpus[cpu] != mycpu())
+    lapicipi(cpus[cpu].apicid, T_IRQ0 + IRQ_WAKEUP);
+}
+
+// p was just queued: make sure a cpu is awake to run it. Wake p's cpu
+// if it is halted in scheduler(), otherwise any halted cpu p may run
+// on, which will steal p. Caller holds ptable.lock.
+static void
+kick(struct proc *p)
+{
+  int i, cpu = p->cpu;
+
+  if (!cpus[cpu].idle)
+  {
+    for (i = 0; i < ncpu && !(cpus[i].idle && (p->affinity & (1 << i))); i++)
+      ;
+    if (i == ncpu)
+      return;
+    cpu = i;
+  }
+  wakecpu(cpu);
+}
+
+// Take a RUNNABLE p off its cpu's run queue; the caller
+// changes its state. Caller holds ptable.lock.
+static void
+rqremove(struct proc *p)
+{
+  struct runq *rq = &runq[p->cpu];
+  int i = qslot(p);
+
+  if (throttled(p))
+  {
+    qremove(&rq->throttled, p);
+    return;
+  }
+  qremove(&rq->q[i], p);
+  if (is_empty(&rq->q[i]))
+    rq->nonempty &= ~(1 << i);
+  rq->nrunnable--;
+}
+
+// First slot of the process table, or 0 while it has none.
+static struct proc *
+firstproc(void)
+{
+  return ptable.pages ? ptable.pages->proc : 0;
+}
+
+// The table page holding slot p.
+static struct procpage *
+procpage(struct proc *p)
+{
+  return (struct procpage *)PGROUNDDOWN((uint)p);
+}
+
+// Slot after p in the process table, or 0 if p is the last.
+static struct proc *
+nextproc(struct proc *p)
+{
+  struct procpage *pg = procpage(p);
+
+  if (++p < &pg->proc[NPROCPAGE])
+    return p;
+  return pg->next ? pg->next->proc : 0;
+}
+
+// Add a page of UNUSED slots to the process table.
+// Returns -1 if there is no memory. Caller holds ptable.lock.
+static int
+growptable(void)
+{
+  struct procpage *pg;
+  int i;
+
+  if ((pg = (struct procpage *)kalloc()) == 0)
+    return -1;
+  memset(pg, 0, PGSIZE);
+  pg->next = ptable.pages;
+  ptable.pages = pg;
+  for (i = 0; i < NPROCPAGE; i++)
+    enqueue(&ptable.free, &pg->proc[i]);
+  return 0;
+}
+
+// Take p's table page out of the table and free it. p was the last
+// slot in use there, so the others are all on the free list.
+// Caller holds ptable.lock.
+static void
+shrinkptable(struct proc *p)
+{
+  struct procpage *pg = procpage(p), **pp;
+  int i;
+
+  for (i = 0; i < NPROCPAGE; i++)
+    if (&pg->proc[i] != p)
+      qremove(&ptable.free, &pg->proc[i]);
+  for (pp = &ptable.pages; *pp != pg; pp = &(*pp)->next)
+    ;
+  *pp = pg->next;
+  for (i = 0; i < ncpu; i++) // sched() must not run a slot that is gone
+    if (cpus[i].handoff && procpage(cpus[i].handoff) == pg)
+      cpus[i].handoff = 0;
+  kfree((char *)pg);
+}
+
+// Give slot p back to the process table. Caller holds ptable.lock and
+// must not go on walking the table from p.
+static void
+freeproc(struct proc *p)
+{
+  struct procpage *pg = procpage(p);
+
+  p->state = UNUSED;
+  if (--pg->nused == 0 && ptable.free.size >= 2 * NPROCPAGE - 1)
+    shrinkptable(p);
+  else
+    enqueue(&ptable.free, p);
 }
 
 // Must be called with interrupts disabled
@@ -76,7 +447,8 @@ myproc(void)
 }
 
 // PAGEBREAK: 32
-//  Look in the process table for an UNUSED proc.
+//  Take an UNUSED proc from the process table, growing
+//  the table if it has none.
 //  If found, change state to EMBRYO and initialize
 //  state required to run in the kernel.
 //  Otherwise return 0.
@@ -87,23 +459,27 @@ allocproc(void)
   char *sp;
   acquire(&ptable.lock);
 
-  for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
-    if (p->state == UNUSED)
-      goto found;
-
-  release(&ptable.lock);
-  return 0;
-
-found:
+  if (is_empty(&ptable.free) && growptable() < 0)
+  {
+    release(&ptable.lock);
+    return 0;
+  }
+  p = dequeue(&ptable.free);
+  procpage(p)->nused++;
   p->state = EMBRYO;
   p->pid = nextpid++;
   p->priority = 3;
   p->timequantum = 0;
   p->level = 0;
+  p->rtbudget = p->rtperiod = 0;
+  p->waitlock = 0;
+  p->inherited = 0;
+  memset(&p->stat, 0, sizeof(p->stat));
   // Allocate kernel stack.
   if ((p->kstack = kalloc()) == 0)
   {
-    p->state = UNUSED;
+    freeproc(p);
+    release(&ptable.lock);
     return 0;
   }
   sp = p->kstack + KSTACKSIZE;
@@ -121,7 +497,10 @@ found:
   p->context = (struct context *)sp;
   memset(p->context, 0, sizeof *p->context);
   p->context->eip = (uint)forkret;
-  enqueue(0, p - ptable.proc);//L0로 넣어줍니다.
+  p->affinity = ~0;
+  p->cpu = leastloaded(p->affinity); // RUNNABLE이 되면 이 CPU의 L0로 들어간다.
+  p->boostepoch = runq[p->cpu].boostepoch;
+  p->pass = runq[p->cpu].vpass;
   release(&ptable.lock);
   return p;
 }
@@ -155,7 +534,8 @@ void userinit(void)
   // writes to be visible, and the lock is also needed
   // because the assignment might not be atomic.
   acquire(&ptable.lock);
-  p->state = RUNNABLE;
+  setrunnable(p);
+  kick(p);
   release(&ptable.lock);
 }
 
@@ -169,8 +549,10 @@ int growproc(int n)
   sz = curproc->sz;
   if (n > 0)
   {
-    if ((sz = allocuvm(curproc->pgdir, sz, sz + n)) == 0)
+    // 페이지는 처음 건드릴 때 할당한다 (trap.c의 T_PGFLT, lazyfault).
+    if (sz + n < sz || sz + n >= KERNBASE)
       return -1;
+    sz += n;
   }
   else if (n < 0)
   {
@@ -203,11 +585,17 @@ int fork(void)
   {
     kfree(np->kstack);
     np->kstack = 0;
-    np->state = UNUSED;
+    acquire(&ptable.lock);
+    freeproc(np);
+    release(&ptable.lock);
     return -1;
   }
+  // copyuvm made the parent's pages read-only; drop the writable TLB entries.
+  lcr3(V2P(curproc->pgdir));
   np->sz = curproc->sz;
   np->parent = curproc;
+  // setrunnable()이 허용된 CPU로 옮긴다. reservation은 물려주지 않는다.
+  np->affinity = curproc->rtperiod ? curproc->rtaffinity : curproc->affinity;
   *np->tf = *curproc->tf;
 
   // Clear %eax so that fork returns 0 in the child.
@@ -224,7 +612,8 @@ int fork(void)
 
   acquire(&ptable.lock);
 
-  np->state = RUNNABLE;
+  setrunnable(np);
+  kick(np);
 
   release(&ptable.lock);
 
@@ -264,7 +653,7 @@ void exit(void)
   wakeup1(curproc->parent);
 
   // Pass abandoned children to init.
-  for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+  for (p = firstproc(); p; p = nextproc(p))
   {
     if (p->parent == curproc)
     {
@@ -293,7 +682,7 @@ int wait(void)
   {
     // Scan through table looking for exited children.
     havekids = 0;
-    for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+    for (p = firstproc(); p; p = nextproc(p))
     {
       if (p->parent != curproc)
         continue;
@@ -309,7 +698,7 @@ int wait(void)
         p->parent = 0;
         p->name[0] = 0;
         p->killed = 0;
-        p->state = UNUSED;
+        freeproc(p);
         release(&ptable.lock);
         return pid;
       }
@@ -327,6 +716,49 @@ int wait(void)
   }
 }
 
+// p was just picked to run on c: account for the time slice it is
+// about to start. Caller holds ptable.lock.
+static void
+startslice(struct proc *p, struct cpu *c)
+{
+  setcpu(p, c - cpus); // 다시 RUNNABLE이 되면 이 CPU의 큐로 들어간다
+  p->lastran = ticks;
+  countpick(p);
+  if (stridden(p)) // stride는 quantum 대신 pass로 센다
+  {
+    runq[p->cpu].vpass = p->pass;
+    p->pass += STRIDE1 >> (NPRIO - 1 - p->priority);
+  }
+  else if (p->rtperiod == 0) // real-time은 budget으로 따로 센다
+  {
+    p->timequantum++; // tq 증가
+    if (p->timequantum >= policy.quantum[p->level]) // 그 레벨의 quantum을 다 썼다면
+    {
+      p->timequantum = 0; // 큐레벨에 상관없이 timequantum = 0 초기화
+      if (p->level < policy.nlevel - 1) // 마지막 레벨이 아니라면
+      {
+        if (policy.demote == MLFQ_DEMOTE_STEP)
+          p->level++; // 큐 레벨 하나 내려보내야함.
+        else if (policy.demote == MLFQ_DEMOTE_BOTTOM)
+          p->level = policy.nlevel - 1; // 마지막 레벨로 바로 내려보낸다.
+        if (policy.demote != MLFQ_DEMOTE_NONE)
+        {
+          p->stat.demotions++;
+          sysstat.demotions++;
+        }
+      }
+      else // 마지막 레벨이라면
+      {
+        p->priority--;       // PRIORITY감소시키고
+        if (p->priority < 0) // 0보다 작다면
+        {
+          p->priority = 0; // PRIORITY는 0으로 유지
+        }
+      }
+    }
+  }
+}
+
 // PAGEBREAK: 42
 //  Per-CPU process scheduler.
 //  Each CPU calls scheduler() after setting itself up.
@@ -339,51 +771,22 @@ void scheduler(void)
 {
   struct proc *p;
   struct cpu *c = mycpu();
+  struct runq *rq = &runq[c - cpus];
   c->proc = 0;
   for (;;)
   {
     // Enable interrupts on this processor.
     sti();
     acquire(&ptable.lock);
-    if (isLocked == 0) // 잠기지 않았다면
+    if ((p = pick_in_mlfq(rq)) == 0) // 내 CPU의 큐에서 먼저 뽑고
+      p = steal(rq);                 // 없으면 다른 CPU의 큐에서 훔쳐온다
+    if (p == 0)                      // 다 자고있다면...
     {
-      pickedProcessIndex = pick_in_mlfq();                   // 정상적인 pick_in_mlfq()호출
-      if (ptable.proc[pickedProcessIndex].state != RUNNABLE) // 다 자고있다면...
-      {
-        release(&ptable.lock); // 다시 for문 돌아와야 하니까 release걸면됨.
-        continue;
-      }
-    }
-    // schedulerLock이 걸려있다면 여기서부터 실행
-    p = &ptable.proc[pickedProcessIndex];
-    if (ptable.proc[pickedProcessIndex].state != RUNNABLE)
-    {
-      release(&ptable.lock);
+      idle(c);
       continue;
     }
-    p->timequantum++; // tq 증가
-    if (p->timequantum < (p->level * 2 + 4)) //tq가 2n+4보다 작다면
-    {
-      enqueue(p->level, pickedProcessIndex); // 원래 레벨로 뽑힌 인덱스 그대로 다시 넣어줌
-    }
-    else if (p->timequantum >= (p->level * 2 + 4)) // 2n+4보다 크다면
-    {
-      p->timequantum = 0; // 큐레벨에 상관없이 timequantum = 0 초기화
-      if (p->level != 2)  // L0나 L1이라면
-      {
-        enqueue(p->level + 1, pickedProcessIndex); // 큐 레벨 하나 내려보내야함.
-        p->level++; //level도 하나 증가
-      }
-      else if (p->level == 2) // L2레벨이라면
-      {
-        enqueue(2, pickedProcessIndex); //L2에 넣어준다.
-        p->priority--;       // PRIORITY감소시키고
-        if (p->priority < 0) // 0보다 작다면
-        {
-          p->priority = 0; // PRIORITY는 0으로 유지
-        }
-      }
-    }
+    startslice(p, c);
+    c->handoff = 0;
     //   Switch to chosen process.  It is the process's job
     //   to release ptable.lock and then reacquire it
     //   before jumping back to us.
@@ -399,6 +802,66 @@ void scheduler(void)
   }
 }
 
+// Some cpu other than cpu0 is not halted in idle(), so ticks has to
+// keep moving for whatever it runs.
+static int
+cpusbusy(void)
+{
+  for (int i = 1; i < ncpu; i++)
+    if (!cpus[i].idle)
+      return 1;
+  return 0;
+}
+
+// Nothing is RUNNABLE for c: release ptable.lock and halt until an
+// interrupt. kick() sends an IPI when work is queued, so the local timer
+// is stretched to the next clock deadline (cpu0) or stopped altogether
+// (other cpus) instead of waking the cpu every tick for nothing.
+// cpu0 keeps time for everyone, so it stays on the periodic tick while
+// another cpu is busy, and a cpu leaving idle() wakes cpu0 to see that.
+static void
+idle(struct cpu *c)
+{
+  uint n;
+
+  xchg(&c->idle, 1); // kick() clears it and sends the IPI
+  release(&ptable.lock);
+  cli();
+  if (c == &cpus[0] && c->idle && cpusbusy())
+    stihlt(); // 타이머 인터럽트가 tick마다 시계를 돌린다.
+  else if (c->idle)
+  {
+    n = (c == &cpus[0]) ? clockdeadline() : 0;
+    c->tickless = 1;
+    lapiconeshot(n);
+    stihlt();
+    cli();
+    n = lapicwake();
+    c->tickless = 0;
+    if (c == &cpus[0])
+      clockadvance(n);
+    mlfq_tick(n);
+  }
+  xchg(&c->idle, 0);
+  if (c != &cpus[0] && cpus[0].idle) // cpu0 may be tickless; see cpusbusy()
+    wakecpu(0);
+}
+
+// The process c->handoff may be run directly on c instead of going
+// through scheduler(): it is still the process that was woken and
+// RUNNABLE, may run on c, and nothing more urgent is queued on c.
+// Caller holds ptable.lock.
+static int
+canhandoff(struct proc *next, struct cpu *c)
+{
+  struct runq *rq = &runq[c - cpus];
+
+  return next->pid == c->handoffpid && next->state == RUNNABLE &&
+         !throttled(next) &&
+         (next->affinity & (1 << (c - cpus))) &&
+         (rq->nonempty == 0 || __builtin_ctz(rq->nonempty) >= qslot(next));
+}
+
 // Enter scheduler.  Must hold only ptable.lock
 // and have changed proc->state. Saves and restores
 // intena because intena is a property of this
@@ -406,10 +869,15 @@ void scheduler(void)
 // be proc->intena and proc->ncli, but that would
 // break in the few places where a lock is held but
 // there's no process.
+// If c->handoff can run here, swtch straight to it instead:
+// a process that wakes its partner and then blocks, like either
+// end of a pipe, skips the trip through scheduler().
 void sched(void)
 {
   int intena;
   struct proc *p = myproc();
+  struct cpu *c;
+  struct proc *next;
   if (!holding(&ptable.lock))
     panic("sched ptable.lock");
   if (mycpu()->ncli != 1)
@@ -418,8 +886,21 @@ void sched(void)
     panic("sched running");
   if (readeflags() & FL_IF)
     panic("sched interruptible");
-  intena = mycpu()->intena;
-  swtch(&p->context, mycpu()->scheduler);
+  c = mycpu();
+  intena = c->intena;
+  next = c->handoff;
+  c->handoff = 0;
+  if (next && next != p && canhandoff(next, c))
+  {
+    rqremove(next);
+    startslice(next, c);
+    c->proc = next;
+    switchuvm(next);
+    next->state = RUNNING;
+    swtch(&p->context, next->context);
+  }
+  else
+    swtch(&p->context, c->scheduler);
   mycpu()->intena = intena;
 }
 
@@ -427,11 +908,37 @@ void sched(void)
 void yield(void)
 {
   acquire(&ptable.lock); // DOC: yieldlock
-  myproc()->state = RUNNABLE;
+  mycpu()->handoff = 0; // 시간이 다 된 것이니 MLFQ 순서대로 뽑는다.
+  setrunnable(myproc());
   sched();
   release(&ptable.lock);
 }
 
+// Give up the CPU to process pid, which runs next on this cpu unless
+// something more urgent is queued here. Returns -1 if pid is not
+// RUNNABLE or may not run on this cpu.
+int yield_to(int pid)
+{
+  struct proc *p;
+
+  acquire(&ptable.lock);
+  for (p = firstproc(); p; p = nextproc(p))
+  {
+    if (p->pid != pid || p->state != RUNNABLE)
+      continue;
+    if (!(p->affinity & (1 << cpuid())))
+      break;
+    mycpu()->handoff = p;
+    mycpu()->handoffpid = p->pid;
+    setrunnable(myproc());
+    sched();
+    release(&ptable.lock);
+    return 0;
+  }
+  release(&ptable.lock);
+  return -1;
+}
+
 // A fork child's very first scheduling by scheduler()
 // will swtch here.  "Return" to user space.
 void forkret(void)
@@ -501,9 +1008,17 @@ wakeup1(void *chan)
 {
   struct proc *p;
 
-  for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+  for (p = firstproc(); p; p = nextproc(p))
     if (p->state == SLEEPING && p->chan == chan)
-      p->state = RUNNABLE;
+    {
+      setrunnable(p);
+      kick(p);
+      if (mycpu()->proc) // 깨운 쪽이 곧 잠들면 sched()가 바로 넘겨준다.
+      {
+        mycpu()->handoff = p;
+        mycpu()->handoffpid = p->pid;
+      }
+    }
 }
 
 // Wake up all processes sleeping on chan.
@@ -522,14 +1037,17 @@ int kill(int pid)
   struct proc *p;
 
   acquire(&ptable.lock);
-  for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+  for (p = firstproc(); p; p = nextproc(p))
   {
     if (p->pid == pid)
     {
       p->killed = 1;
       // Wake process from sleep if necessary.
       if (p->state == SLEEPING)
-        p->state = RUNNABLE;
+      {
+        setrunnable(p);
+        kick(p);
+      }
       release(&ptable.lock);
       return 0;
     }
@@ -556,7 +1074,7 @@ void procdump(void)
   char *state;
   uint pc[10];
 
-  for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+  for (p = firstproc(); p; p = nextproc(p))
   {
     if (p->state == UNUSED)
       continue;
@@ -577,168 +1095,502 @@ void procdump(void)
 
 int getLevel(void)
 {
-  return myproc()->level;
+  struct proc *p = myproc();
+  int level;
+
+  acquire(&ptable.lock);
+  boostsync(p);
+  level = p->level;
+  release(&ptable.lock);
+  return level;
 }
 
 void setPriority(int pid, int priority)
 {
   struct proc *p;
   acquire(&ptable.lock);
-  for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+  for (p = firstproc(); p; p = nextproc(p))
   {
     if (p->pid == pid)
     {
-      p->priority = priority;
+      boostsync(p);
+      if (p->inherited) // 빌린 priority는 돌려줄 때까지 그대로 둔다.
+        p->basepriority = priority;
+      else if (p->state == RUNNABLE) // 큐에 있다면 새 priority의 큐로 옮긴다.
+      {
+        rqremove(p);
+        p->priority = priority;
+        rqinsert(p);
+      }
+      else
+        p->priority = priority;
     }
   }
   release(&ptable.lock);
 }
 
-void schedulerLock(int password)
+// p is the current process or one of its descendants.
+// Caller holds ptable.lock.
+static int
+ismine(struct proc *p)
 {
-  struct proc *p = myproc();
+  struct proc *curproc = myproc();
+
+  for (; p; p = p->parent)
+    if (p == curproc)
+      return 1;
+  return 0;
+}
+
+// The share of a cpu that budget ticks every period ticks take, in
+// RTUNIT-ths of a percent, rounded up so that adding shares never
+// admits more than the cpu has. budget <= period. budget * 100 *
+// RTUNIT could overflow, so the product is divided a bit at a time,
+// keeping quotient q and remainder r < period.
+static uint rtshare(uint budget, uint period)
+{
+  uint q, r, bit;
+
+  q = r = 0;
+  for (bit = 1 << 31; bit; bit >>= 1)
+  {
+    q <<= 1;
+    r <<= 1;
+    if (r >= period)
+    {
+      r -= period;
+      q++;
+    }
+    if ((100 * RTUNIT) & bit)
+    {
+      r += budget;
+      if (r >= period)
+      {
+        r -= period;
+        q++;
+      }
+    }
+  }
+  return q + (r != 0);
+}
+
+// Give process pid, the caller or one of its descendants, a real-time
+// reservation of budget ticks every period ticks, or take it away if
+// budget is 0. Real-time processes are picked ahead of every MLFQ level
+// until their budget for the period runs out. The reservation is
+// admitted on the cpu in pid's affinity with the least reserved, and
+// pid is pinned there; it fails if that would take more than
+// RTMAXSHARE percent of the cpu.
+int setReservation(int pid, int budget, int period)
+{
+  struct proc *p, *target = 0;
+  uint share[NCPU], mask;
+  int i, cpu = -1;
+
+  if (budget < 0 || (budget > 0 && (period < 1 || budget > period ||
+                                    rtshare(budget, period) > RTMAXSHARE * RTUNIT)))
+    return -1;
+  memset(share, 0, sizeof(share));
   acquire(&ptable.lock);
-  if (myproc()->state != RUNNING || isLocked == 1) // state가 RUNNING이 아니거나, 먼저 걸려있었거나
+  for (p = firstproc(); p; p = nextproc(p))
   {
-    release(&ptable.lock);
-    return;
+    if (p->state == UNUSED)
+      continue;
+    if (p->pid == pid)
+      target = p;
+    else if (p->rtperiod)
+      share[p->rtcpu] += rtshare(p->rtbudget, p->rtperiod);
   }
-  if (password == 2019073181) // 비밀번호도 걸려있어야 하고 락도 안걸려있나 확인해야함.
+  if (target == 0 || target->state == ZOMBIE || !ismine(target))
+    goto bad;
+  mask = target->rtperiod ? target->rtaffinity : target->affinity;
+  if (budget > 0)
+  {
+    for (i = 0; i < ncpu; i++)
+      if ((mask & (1 << i)) && (cpu < 0 || share[i] < share[cpu]))
+        cpu = i;
+    if (cpu < 0 || share[cpu] + rtshare(budget, period) > RTMAXSHARE * RTUNIT)
+      goto bad;
+  }
+  if (target->state == RUNNABLE) // 큐를 옮겨야 하니 먼저 뺀다.
+    rqremove(target);
+  target->affinity = budget ? 1 << cpu : mask; // 실행 중이면 setrunnable()이 옮긴다.
+  target->rtaffinity = mask;
+  target->rtcpu = budget ? cpu : 0;
+  target->rtbudget = budget;
+  target->rtperiod = budget ? period : 0;
+  target->rtleft = budget;
+  target->rtnext = ticks + period;
+  if (target->state != RUNNING && !(target->affinity & (1 << target->cpu)))
+    setcpu(target, leastloaded(target->affinity));
+  if (target->state == RUNNABLE)
+  {
+    rqinsert(target);
+    kick(target);
+  }
+  release(&ptable.lock);
+  return 0;
+
+bad:
+  release(&ptable.lock);
+  return -1;
+}
+
+// Let process pid run only on the cpus in mask, bit i for cpu i, and
+// return its previous mask; mask 0 only reads it. A queued process
+// moves at once, a running one when it next becomes RUNNABLE. A
+// real-time process stays pinned to the cpu its reservation is on, so
+// only its own mask is kept, which must still name that cpu.
+// Returns -1 if there is no such process or mask names no cpu.
+int setAffinity(int pid, int mask)
+{
+  struct proc *p;
+  int old;
+
+  if (mask && (mask & ((1 << ncpu) - 1)) == 0)
+    return -1;
+  mask &= (1 << ncpu) - 1;
+  acquire(&ptable.lock);
+  for (p = firstproc(); p; p = nextproc(p))
   {
-    if (cpuid() == 0)
+    if (p->state == UNUSED || p->pid != pid)
+      continue;
+    if (p->rtperiod)
     {
-      acquire(&tickslock);
+      old = p->rtaffinity & ((1 << ncpu) - 1);
+      if (mask && !(mask & (1 << p->rtcpu)))
+        old = -1;
+      else if (mask)
+        p->rtaffinity = mask;
       release(&ptable.lock);
-      ticks = 0;
-      wakeup(&ticks);
-      release(&tickslock);
-      acquire(&ptable.lock);
+      return old;
     }
-    isLocked = 1;
+    old = p->affinity & ((1 << ncpu) - 1);
+    if (mask && p->state == RUNNABLE)
+    {
+      rqremove(p);
+      p->affinity = mask;
+      if (!(mask & (1 << p->cpu)))
+        setcpu(p, leastloaded(mask));
+      rqinsert(p);
+      kick(p);
+    }
+    else if (mask)
+      p->affinity = mask;
     release(&ptable.lock);
-    return;
+    return old;
   }
-  else
+  release(&ptable.lock);
+  return -1;
+}
+
+// Where p stands in MLFQ pick order, lower first: its level, or on
+// the last level its priority after it.
+static int
+rank(struct proc *p)
+{
+  boostsync(p);
+  if (p->level < policy.nlevel - 1)
+    return p->level;
+  return policy.nlevel - 1 + p->priority;
+}
+
+// Lend waiter's level and priority to holder if waiter would run
+// first, keeping holder's own in base*. Real-time holders are left
+// alone. Returns whether holder was raised. Caller holds ptable.lock.
+static int
+lend(struct proc *holder, struct proc *waiter)
+{
+  if (holder->rtperiod || rank(waiter) >= rank(holder))
+    return 0;
+  if (holder->state == RUNNABLE)
+    rqremove(holder);
+  if (!holder->inherited)
   {
-    cprintf("password error cur process's pid is %d, timequantum is %d, Queue level is %d\n", p->pid, p->timequantum, p->level);
-    release(&ptable.lock);
-    //kill(myproc()->pid);
-    exit();
+    holder->inherited = 1;
+    holder->baselevel = holder->level;
+    holder->basepriority = holder->priority;
   }
+  holder->level = waiter->level;
+  holder->priority = waiter->priority;
+  if (holder->state == RUNNABLE)
+    rqinsert(holder);
+  return 1;
 }
 
-void schedulerUnlock(int password)
+// The current process is about to sleep waiting for lk: lend its
+// priority to lk's holder, and on down the chain if that holder is
+// itself waiting for a sleeplock, so a holder MLFQ has demoted cannot
+// keep a more urgent waiter blocked. Caller holds lk->lk.
+void inheritpriority(struct sleeplock *lk)
 {
-  struct proc *p = myproc();
+  struct proc *p = myproc(), *h;
+  int depth;
+
   acquire(&ptable.lock);
-  if (myproc()->state != RUNNING ||isLocked == 0)
-  {
-    release(&ptable.lock);
+  p->waitlock = lk;
+  // Real chains are short; the bound also ends a deadlock cycle.
+  for (h = lk->holder, depth = 0; h && depth < 8 && lend(h, p); depth++)
+    h = h->waitlock ? h->waitlock->holder : 0;
+  release(&ptable.lock);
+}
+
+// p released a sleeplock: give back what it was lent, then borrow
+// again from whoever still waits on a sleeplock p holds.
+void disinheritpriority(struct proc *p)
+{
+  struct proc *q;
+
+  if (!p->inherited)
     return;
+  acquire(&ptable.lock);
+  boostsync(p);
+  if (p->inherited)
+  {
+    if (p->state == RUNNABLE)
+      rqremove(p);
+    p->level = p->baselevel;
+    p->priority = p->basepriority;
+    p->inherited = 0;
+    if (p->state == RUNNABLE)
+      rqinsert(p);
+    for (q = firstproc(); q; q = nextproc(q))
+      if (q->state == SLEEPING && q->waitlock && q->waitlock->holder == p)
+        lend(p, q);
   }
+  release(&ptable.lock);
+}
 
-  if (password == 2019073181) // 비밀번호도 맞아야 하고 락도 걸려있어야 한다.
-  {
-    enqueue(0, p - ptable.proc);
-    p->level = 0;
-    p->timequantum = 0;
-    p->priority = 3;
-    isLocked = 0; // scheduler 풀어줘야함.
-    release(&ptable.lock);
+// Charge a tick to this cpu's real-time process, if it is running one.
+// The timer then makes it yield, and it waits on the throttled queue
+// once its budget is gone.
+static void
+rtcharge(void)
+{
+  struct proc *p = mycpu()->proc;
+
+  if (p == 0 || p->rtperiod == 0)
     return;
-  }
-  else
+  acquire(&ptable.lock);
+  if (p->rtperiod)
   {
-    cprintf("password error cur process's pid is %d, timequantum is %d, Queue level is %d\n", p->pid, p->timequantum, p->level);
-    release(&ptable.lock);
-    // kill(myproc()->pid); 
-    exit();
+    rtrefill(p);
+    if (p->rtleft > 0)
+      p->rtleft--;
   }
+  release(&ptable.lock);
+}
+
+// Earliest tick at which a throttled process gets its budget back,
+// ~0 if none. Read by cpu0 without ptable.lock when it decides how
+// long to idle; rqinsert() kicks it when this moves earlier.
+uint rtdeadline(void)
+{
+  return rtwake;
 }
 
-int pick_in_mlfq()
-{ // 큐에서 MLFQ 를 통해 process의 !INDEX!를 뽑는다.
-  // L0 큐
-  int proc_index = -1; // 뽑힌 index
-  int sz = mlfq[0].size; 
-  for (int i = 0; i < sz; i++)//L0의 사이즈만큼
+// Called by cpu0 once ticks reaches rtdeadline(): move every throttled
+// process whose new period has started back onto its cpu's run queue.
+void rtreplenish(void)
+{
+  struct proc *p, *next;
+  int i;
+
+  acquire(&ptable.lock);
+  rtwake = ~0;
+  for (i = 0; i < ncpu; i++)
   {
-    proc_index = dequeue(0); // dequeue의 파라미터는 level 즉 dequeue(0)은 L0큐에서 뽑겠다는 소리.
-    if (ptable.proc[proc_index].state == RUNNABLE) //상태가 runnable이면
+    for (p = runq[i].throttled.head; p; p = next)
     {
-      ptable.proc[proc_index].level = 0; //뽑힐테니까 level을 0로 설정해주고
-      return proc_index; //그 인덱스 리턴
+      next = p->qnext;
+      if ((int)(ticks - p->rtnext) < 0)
+      {
+        if (p->rtnext < rtwake)
+          rtwake = p->rtnext;
+        continue;
+      }
+      qremove(&runq[i].throttled, p);
+      rtrefill(p);
+      rqinsert(p);
+      kick(p);
     }
-    enqueue(0, proc_index); //runnable이 아니면 다시 큐에 넣어준다.
   }
+  release(&ptable.lock);
+}
+
+// rq에서 MLFQ 를 통해 process를 뽑는다.
+// 비어있지 않은 가장 앞 큐의 head를 큐에서 빼서 리턴하고, 없으면 0.
+static struct proc *pick_in_mlfq(struct runq *rq)
+{
+  struct proc *p;
 
-  // L1 큐
-  sz = mlfq[1].size;
-  for (int i = 0; i < sz; i++) //L1의 사이즈만큼
+  if (rq->nonempty == 0)
+    return 0;
+  p = rq->q[__builtin_ctz(rq->nonempty)].head;
+  rqremove(p);
+  return p;
+}
+
+// The process an idle cpu should take from peer rq: the first one in
+// pick order that may run on cpu, preferring within a queue one that
+// has not run for CACHEHOT ticks and so has little cache left to lose.
+// 0 if none may run there.
+static struct proc *stealable(struct runq *rq, int cpu)
+{
+  struct proc *p, *hot;
+  uint bits;
+  int i;
+
+  for (bits = rq->nonempty; bits; bits &= bits - 1)
   {
-    proc_index = dequeue(1); // dequeue의 파라미터는 level 즉 dequeue(0)은 L0큐에서 뽑겠다는 소리.
-    if (ptable.proc[proc_index].state == RUNNABLE)//runnable이면
+    i = __builtin_ctz(bits);
+    hot = 0;
+    for (p = rq->q[i].head; p; p = p->qnext)
     {
-      ptable.proc[proc_index].level = 1; //레벨 다시 1로 세팅
-      return proc_index;//인덱스 리턴
+      if (!(p->affinity & (1 << cpu)))
+        continue;
+      if (ticks - p->lastran >= CACHEHOT)
+        return p;
+      if (hot == 0)
+        hot = p;
     }
-    enqueue(1, proc_index); //runnable이 아니면 다시 L1에넣는다.
+    if (hot)
+      return hot;
   }
-  // L2 큐
-  sz = mlfq[2].size;//L2의 사이즈만큼
-  int minPriority = 4;//가장 작은 priority를 뽑을 예정. max값인 3보다 큰 4로 세팅
-  for (int i = 0; i < mlfq[2].size; i++) // 현재 L2큐에서 RUNNABLE하면서 priority가 가장 낮은 애를 찾는 과정
+  return 0;
+}
+
+// Nothing RUNNABLE on rq: pull work from the busiest peer that has
+// something this cpu may run. Like pick_in_mlfq(), the stolen process
+// comes back dequeued.
+static struct proc *steal(struct runq *rq)
+{
+  struct proc *p, *best = 0;
+  int i, max = 0;
+
+  for (i = 0; i < ncpu; i++)
   {
-    proc_index = dequeue(2);//뽑고
-    if (ptable.proc[proc_index].state == RUNNABLE && ptable.proc[proc_index].priority < minPriority)
-    {                                // RUNNABLE하고 현재 minspriority더 낮은 애들
-      minPriority = ptable.proc[proc_index].priority; // 현재 L2에서 가장 낮은 priority
-    }
-    enqueue(2, proc_index); //아니면 다시 넣는다. 
-  }
-  for (int i = 0; i < sz; i++) //다시 L2의 사이즈만큼
-  { 
-    proc_index = dequeue(2); //뽑고
-    if (ptable.proc[proc_index].state == RUNNABLE) //runnable인 process중에서
+    if (&runq[i] != rq && runq[i].nrunnable > max &&
+        (p = stealable(&runq[i], rq - runq)) != 0)
     {
-      if (ptable.proc[proc_index].priority == minPriority) //아까 뽑은 minPriority로 처음 나오는 process를 
-      {
-        ptable.proc[proc_index].level = 2; //레벨 2로 다시 세팅하고
-        return proc_index; //proc_index 리턴
-      }
+      max = runq[i].nrunnable;
+      best = p;
     }
-    enqueue(2, proc_index); //
   }
-  return proc_index;
+  if (best)
+    rqremove(best);
+  return best;
 }
 
-void priority_boosting() // PRIORITY BOOSTING
+// PRIORITY BOOSTING: every queued process goes, in pick order, to the
+// back of the queue a fresh L0 process would join, by splicing whole
+// queues. Resetting each process's level, priority and quantum is left
+// to boostsync(), so the boost costs O(NRUNQ) in the timer interrupt
+// however many processes this cpu has.
+static void priority_boosting(struct runq *rq)
 {
-  struct proc *p = myproc();
-  int index;
-  int sz = mlfq[1].size;
-  for (int i = 0; i < sz; i++) // L1 큐 사이즈만큼
+  int i, top;
+
+  rq->boostepoch++;
+  if (policy.nlevel > 1)
+    top = 1; // L0
+  else if (policy.lastlevel == MLFQ_LAST_STRIDE)
+    top = STRIDEQ;
+  else
+    top = MLFQ_MAXLEVEL + NPRIO - 1; // L0이 마지막 레벨이면 priority 3의 큐
+  for (i = RTQ + 1; i < NRUNQ; i++)
+    if (i != top && !is_empty(&rq->q[i]))
+      qsplice(&rq->q[top], &rq->q[i]);
+  rq->nonempty &= 1 << RTQ;
+  if (!is_empty(&rq->q[top]))
+    rq->nonempty |= 1 << top;
+}
+
+// Called for every n ticks of a cpu's timer. Each cpu boosts its own run
+// queues every boostperiod of its own ticks instead of cpu0 boosting
+// everyone's.
+void mlfq_tick(uint n)
+{
+  struct runq *rq = &runq[cpuid()];
+
+  rtcharge();
+  rq->boostticks += n;
+  if (policy.boostperiod == 0 || rq->boostticks < policy.boostperiod)
+    return;
+  rq->boostticks = 0;
+  acquire(&ptable.lock);
+  priority_boosting(rq);
+  release(&ptable.lock);
+}
+
+// Copy the policy in force to old, if non-zero, and install np, if
+// non-zero, as one atomic swap. Queued processes are re-sorted for the
+// new level layout and levels past the new last level are clamped.
+// Returns -1 if np is malformed.
+int setMLFQPolicy(struct mlfqpolicy *np, struct mlfqpolicy *old)
+{
+  struct proc *p;
+  Queue requeue;
+  int i;
+
+  if (np)
   {
-    index = dequeue(1); // L1에서 빼서
-    enqueue(0, index);  // L0에 넣는다.
+    if (np->nlevel < 1 || np->nlevel > MLFQ_MAXLEVEL || np->boostperiod < 0 ||
+        np->demote < MLFQ_DEMOTE_STEP || np->demote > MLFQ_DEMOTE_NONE ||
+        np->lastlevel < MLFQ_LAST_PRIORITY || np->lastlevel > MLFQ_LAST_STRIDE)
+      return -1;
+    for (i = 0; i < np->nlevel; i++)
+      if (np->quantum[i] < 1)
+        return -1;
   }
-  sz = mlfq[2].size;
-  for (int i = 0; i < sz; i++) // L2 큐 사이즈만큼
+
+  acquire(&ptable.lock);
+  if (old)
+    *old = policy;
+  if (np)
+  {
+    qinit(&requeue);
+    for (i = 0; i < ncpu; i++)
+      rqdrain(&runq[i], &requeue);
+    policy = *np;
+    for (p = firstproc(); p; p = nextproc(p))
+    {
+      if (p->level >= policy.nlevel)
+        p->level = policy.nlevel - 1;
+      if (p->baselevel >= policy.nlevel)
+        p->baselevel = policy.nlevel - 1;
+    }
+    while ((p = dequeue(&requeue)) != 0)
+      rqinsert(p);
+  }
+  release(&ptable.lock);
+  return 0;
+}
+
+// Copy the scheduler counters of process pid, or the system-wide
+// ones if pid is 0, into st. Returns -1 if there is no such process.
+int getSchedStat(int pid, struct schedstat *st)
+{
+  struct proc *p;
+
+  acquire(&ptable.lock);
+  if (pid == 0)
   {
-    index = dequeue(2); // L2에서 빼서
-    enqueue(0, index);  // L0에 넣는다.
+    *st = sysstat;
+    release(&ptable.lock);
+    return 0;
   }
-  sz = mlfq[0].size; //L0의 사이즈만큼
-  for (int i = 0; i < sz; i++)
+  for (p = firstproc(); p; p = nextproc(p))
   {
-    index = dequeue(0); //빼서 인덱스를 찾고
-    p = &ptable.proc[index]; //process할당하고
-    p->timequantum = 0; // timequnatum 0으로 할당하고
-    p->level = 0; //level도 다시 0으로 넣고
-    p->priority = 3; // priority도 다시 3으로 세팅
-    enqueue(0, index); // 모든 과정 거친 후 L0에 넣는다.
+    if (p->state != UNUSED && p->pid == pid)
+    {
+      *st = p->stat;
+      release(&ptable.lock);
+      return 0;
+    }
   }
-  return;
+  release(&ptable.lock);
+  return -1;
 }
 
 void printProcessInfo(struct proc *p)
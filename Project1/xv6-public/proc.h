@@ -5,9 +5,13 @@ struct cpu {
   struct taskstate ts;         // Used by x86 to find stack for interrupt
   struct segdesc gdt[NSEGS];   // x86 global descriptor table
   volatile uint started;       // Has the CPU started?
+  volatile uint idle;          // Halted in scheduler() waiting for work?
+  int tickless;                // Timer in one-shot mode while idle?
   int ncli;                    // Depth of pushcli nesting.
   int intena;                  // Were interrupts enabled before pushcli?
   struct proc *proc;           // The process running on this cpu or null
+  struct proc *handoff;        // Woken by proc; sched() may run it next
+  int handoffpid;              // handoff's pid, in case its slot is reused
 };
 
 extern struct cpu cpus[NCPU];
@@ -44,6 +48,26 @@ struct proc {
   int priority;                // priority
   int timequantum;             // timequantum
   int level;                   // cur Q level
+  int cpu;                     // cpu whose run queue holds this process
+  uint affinity;               // cpus it may run on, bit i for cpu i
+  uint lastran;                // ticks when it was last picked
+  uint boostepoch;             // its cpu's boosts it has applied
+  struct sleeplock *waitlock;  // sleeplock it is waiting for, or 0
+  int inherited;               // level/priority lent by a waiter; the
+  int baselevel;               //   process's own ones are kept here
+  int basepriority;
+  struct proc *qnext;          // run queue links while RUNNABLE,
+                               //   free list links while UNUSED
+  struct proc *qprev;
+  uint readyat;                // ticks when it last became RUNNABLE
+  uint pass;                   // stride pass on the last level
+  int rtbudget;                // real-time reservation: ticks per period,
+  int rtperiod;                //   0 if not real-time
+  int rtleft;                  // budget left in the current period
+  uint rtnext;                 // ticks when the next period starts
+  int rtcpu;                   // cpu the reservation was admitted on; the
+  uint rtaffinity;             //   process is pinned there, its own mask kept here
+  struct schedstat stat;       // scheduler counters, see getSchedStat()
   struct proc *parent;         // Parent process
   struct trapframe *tf;        // Trap frame for current syscall
   struct context *context;     // swtch() here to run process
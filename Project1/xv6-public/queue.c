@@ -1,47 +1,91 @@
 #include "types.h"
 #include "defs.h"
+#include "param.h"
+#include "mmu.h"
+#include "mlfq.h"
+#include "proc.h"
 #include "queue.h"
 
-int enqueue(int level, int index)
-{ 
-	mlfq[level].rear = (mlfq[level].rear + 1) % 64;		//	rear 하나 증가시키기
-	mlfq[level].index_list[mlfq[level].rear] = index; //	list의 rear에 data 추가
-	mlfq[level].size++;
+/*		큐의 맨 뒤에 p 추가		*/
+int enqueue(Queue *q, struct proc *p)
+{
+	p->qnext = 0;
+	p->qprev = q->tail;
+	if (q->tail)
+		q->tail->qnext = p;
+	else
+		q->head = p;
+	q->tail = p;
+	q->size++;
 	return 1;
 }
 
-/*		큐 데이터 꺼내기		*/
-int dequeue(int level)
-{ 
-	mlfq[level].front = (mlfq[level].front + 1) % 64;
-	mlfq[level].size--;
-	return mlfq[level].index_list[mlfq[level].front];
+/*		큐 데이터 꺼내기, 비어있으면 0		*/
+struct proc *dequeue(Queue *q)
+{
+	struct proc *p = q->head;
+	if (p)
+		qremove(q, p);
+	return p;
 }
 
-/*		공백 상태인지 여부		*/
-int is_empty(int level)
+/*		p를 큐 중간에서 바로 빼기		*/
+void qremove(Queue *q, struct proc *p)
 {
-	if (mlfq[level].front == mlfq[level].rear)
-		return 1;
+	if (p->qprev)
+		p->qprev->qnext = p->qnext;
+	else
+		q->head = p->qnext;
+	if (p->qnext)
+		p->qnext->qprev = p->qprev;
 	else
-		return 0;
+		q->tail = p->qprev;
+	p->qnext = p->qprev = 0;
+	q->size--;
 }
 
-/*		포화 상태인지 여부		*/
-int is_full(int level)
+/*		at 바로 앞에 p 끼워넣기, at이 0이면 맨 뒤		*/
+void qinsertbefore(Queue *q, struct proc *at, struct proc *p)
 {
-	if (mlfq[level].size==64) 
-		return 1;
+	if (at == 0)
+	{
+		enqueue(q, p);
+		return;
+	}
+	p->qnext = at;
+	p->qprev = at->qprev;
+	if (at->qprev)
+		at->qprev->qnext = p;
 	else
-		return 0;
+		q->head = p;
+	at->qprev = p;
+	q->size++;
 }
 
-void qinit()
+/*		src를 통째로 dst 뒤에 붙이고 src는 비우기		*/
+void qsplice(Queue *dst, Queue *src)
 {
-	for (int i = 0; i < 3; i++)
-	{
-		mlfq[i].front = 0;
-		mlfq[i].rear = 0;
-		mlfq[i].size = 0;
-	}
-}
\ No newline at end of file
+	if (src->head == 0)
+		return;
+	src->head->qprev = dst->tail;
+	if (dst->tail)
+		dst->tail->qnext = src->head;
+	else
+		dst->head = src->head;
+	dst->tail = src->tail;
+	dst->size += src->size;
+	qinit(src);
+}
+
+/*		공백 상태인지 여부		*/
+int is_empty(Queue *q)
+{
+	return q->head == 0;
+}
+
+void qinit(Queue *q)
+{
+	q->head = 0;
+	q->tail = 0;
+	q->size = 0;
+}
@@ -1,14 +1,15 @@
+// Run queue of RUNNABLE processes, linked through proc.qnext/qprev
+// so that removing a process from the middle is O(1).
 typedef struct queue{
-	int rear;
-	int front;
-  int index_list[64];
+  struct proc *head;
+  struct proc *tail;
   int size;
 }Queue;
 
-Queue mlfq[3];
-
-int enqueue(int level, int index);
-int dequeue(int level);
-int is_full(int level);
-int is_empty(int level);
-void qinit();
\ No newline at end of file
+int enqueue(Queue *q, struct proc *p);
+struct proc *dequeue(Queue *q);
+void qremove(Queue *q, struct proc *p);
+void qinsertbefore(Queue *q, struct proc *at, struct proc *p);
+void qsplice(Queue *dst, Queue *src);
+int is_empty(Queue *q);
+void qinit(Queue *q);
@@ -0,0 +1,228 @@
+#include "types.h"
+#include "stat.h"
+#include "fcntl.h"
+#include "user.h"
+#include "mlfq.h"
+
+// Replay a scheduling trace and report how the policy in force ran it.
+//   replay [tracefile]            (default sample.trace)
+// Each line of the trace is one job, in order of arrival, and # starts
+// a comment. A job is its arrival time, then alternating cpu bursts
+// and sleeps, all in ticks: "10 3 20 3" arrives at tick 10, computes
+// for 3 ticks, sleeps for 20 and computes for 3 more. Bursts are a
+// fixed amount of work, calibrated against the timer before the run,
+// so the same trace is the same workload under every policy and cpu
+// count.
+
+#define MAXJOB   64
+#define MAXPHASE 16
+#define MAXTRACE 4096
+
+struct job {
+  int arrival;
+  int nphase;
+  int phase[MAXPHASE];   // even: cpu burst, odd: sleep
+  int start;             // ticks from arrival to first running
+  int end;               // ticks from arrival to finishing
+  uint slices[MLFQ_MAXLEVEL];
+};
+
+// What a job reports through the pipe when it finishes. The size
+// divides the pipe buffer, so reports from different jobs are never
+// interleaved, even when the pipe fills.
+struct report {
+  int job;
+  int start;
+  int end;
+  uint slices[MLFQ_MAXLEVEL];
+  char pad[64 - 3 * sizeof(int) - MLFQ_MAXLEVEL * sizeof(uint)];
+};
+
+struct job jobs[MAXJOB];
+int njob;
+char trace[MAXTRACE];
+uint spinspertick;
+
+int
+parse(char *path)
+{
+  int fd, n, v, vals[1 + MAXPHASE];
+  char *s, *next;
+  struct job *j;
+
+  if((fd = open(path, O_RDONLY)) < 0)
+    return -1;
+  n = read(fd, trace, sizeof(trace) - 1);
+  close(fd);
+  if(n < 0)
+    return -1;
+  trace[n] = 0;
+
+  for(s = trace; *s; s = next){
+    for(next = s; *next && *next != '\n'; next++)
+      ;
+    if(*next)
+      *next++ = 0;
+    n = 0;
+    while(*s && *s != '#'){
+      if(*s < '0' || *s > '9'){
+        s++;
+        continue;
+      }
+      if(n == 1 + MAXPHASE){
+        printf(2, "replay: job %d has more than %d phases\n", njob, MAXPHASE);
+        return -1;
+      }
+      for(v = 0; *s >= '0' && *s <= '9'; s++)
+        v = v * 10 + *s - '0';
+      vals[n++] = v;
+    }
+    if(n == 0)
+      continue;
+    if(njob == MAXJOB){
+      printf(2, "replay: more than %d jobs\n", MAXJOB);
+      return -1;
+    }
+    j = &jobs[njob++];
+    j->arrival = vals[0];
+    j->nphase = n - 1;
+    memmove(j->phase, vals + 1, j->nphase * sizeof(int));
+  }
+  return 0;
+}
+
+void
+spin(uint n)
+{
+  volatile uint i;
+
+  for(i = 0; i < n; i++)
+    ;
+}
+
+// How many spin() iterations fit in a tick on an idle machine.
+void
+calibrate(void)
+{
+  int t;
+  uint n;
+
+  t = uptime();
+  while(uptime() == t)
+    ;
+  t = uptime();
+  for(n = 0; uptime() < t + 10; n += 1000)
+    spin(1000);
+  spinspertick = n / 10;
+}
+
+void
+runjob(int i, int arrived, int fd)
+{
+  struct job *j = &jobs[i];
+  struct report r;
+  struct schedstat st;
+  int k;
+
+  memset(&r, 0, sizeof(r));
+  r.job = i;
+  r.start = uptime() - arrived;
+  for(k = 0; k < j->nphase; k++){
+    if(k % 2 == 0)
+      spin(j->phase[k] * spinspertick);
+    else
+      sleep(j->phase[k]);
+  }
+  r.end = uptime() - arrived;
+  if(getSchedStat(getpid(), &st) == 0)
+    memmove(r.slices, st.slices, sizeof(r.slices));
+  write(fd, &r, sizeof(r));
+  exit();
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct schedstat before, after;
+  struct report r;
+  struct job *j;
+  int fds[2], i, k, t0, now, pid, makespan;
+  int resp, turn, totalresp, totalturn;
+  uint total, level;
+
+  if(parse(argc > 1 ? argv[1] : "sample.trace") < 0 || njob == 0){
+    printf(2, "replay: cannot read trace %s\n", argc > 1 ? argv[1] : "sample.trace");
+    exit();
+  }
+  if(pipe(fds) < 0){
+    printf(2, "replay: pipe failed\n");
+    exit();
+  }
+  calibrate();
+  printf(1, "%d jobs, %d spins per tick\n", njob, spinspertick);
+
+  getSchedStat(0, &before);
+  t0 = uptime();
+  for(i = 0; i < njob; i++){
+    j = &jobs[i];
+    now = uptime();
+    if(t0 + j->arrival > now)
+      sleep(t0 + j->arrival - now);
+    if((pid = fork()) < 0){
+      printf(2, "replay: fork failed\n");
+      exit();
+    }
+    if(pid == 0){
+      close(fds[0]);
+      runjob(i, t0 + j->arrival, fds[1]);
+    }
+  }
+  close(fds[1]);
+  for(i = 0; i < njob; i++){
+    if(read(fds[0], &r, sizeof(r)) != sizeof(r) || r.job < 0 || r.job >= njob){
+      printf(2, "replay: lost a report\n");
+      exit();
+    }
+    j = &jobs[r.job];
+    j->start = r.start;
+    j->end = r.end;
+    memmove(j->slices, r.slices, sizeof(j->slices));
+  }
+  for(i = 0; i < njob; i++)
+    wait();
+  makespan = uptime() - t0;
+  getSchedStat(0, &after);
+
+  printf(1, "job\tarrive\tresp\tturn\n");
+  totalresp = totalturn = 0;
+  for(i = 0; i < njob; i++){
+    j = &jobs[i];
+    resp = j->start;
+    turn = j->end;
+    totalresp += resp;
+    totalturn += turn;
+    printf(1, "%d\t%d\t%d\t%d\n", i, j->arrival, resp, turn);
+  }
+  printf(1, "mean response %d ticks, mean turnaround %d ticks\n",
+         totalresp / njob, totalturn / njob);
+  printf(1, "throughput %d jobs per 1000 ticks (%d ticks in all)\n",
+         makespan ? njob * 1000 / makespan : 0, makespan);
+
+  total = 0;
+  for(k = 0; k < MLFQ_MAXLEVEL; k++)
+    for(i = 0; i < njob; i++)
+      total += jobs[i].slices[k];
+  printf(1, "time slices by level (jobs; whole system):\n");
+  for(k = 0; k < MLFQ_MAXLEVEL; k++){
+    level = 0;
+    for(i = 0; i < njob; i++)
+      level += jobs[i].slices[k];
+    if(level == 0 && after.slices[k] == before.slices[k])
+      continue;
+    printf(1, "  L%d\t%d (%d%%)\t%d\n", k, level,
+           total ? level * 100 / total : 0, after.slices[k] - before.slices[k]);
+  }
+  printf(1, "demotions %d, boosts %d\n", after.demotions - before.demotions,
+         after.boosts - before.boosts);
+  exit();
+}
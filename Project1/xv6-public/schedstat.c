@@ -0,0 +1,61 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "mlfq.h"
+
+// Print scheduler counters.
+//   schedstat            system-wide, since boot
+//   schedstat pid ...    for each of the given processes
+
+static char *buckets[SCHED_NBUCKET] = {
+  "0", "1", "2-3", "4-7", "8-15", "16-31", "32-63", "64+",
+};
+
+void
+print(struct schedstat *st)
+{
+  struct mlfqpolicy pol;
+  uint total;
+  int i;
+
+  total = 0;
+  for(i = 0; i < SCHED_NBUCKET; i++)
+    total += st->wait[i];
+  printf(1, "run-queue wait (ticks), %d picks:\n", total);
+  for(i = 0; i < SCHED_NBUCKET; i++)
+    printf(1, "  %s\t%d\n", buckets[i], st->wait[i]);
+
+  if(setMLFQPolicy(0, &pol) < 0)
+    pol.nlevel = MLFQ_MAXLEVEL;
+  printf(1, "time slices by level:\n");
+  for(i = 0; i < MLFQ_MAXLEVEL; i++)
+    if(i < pol.nlevel || st->slices[i])
+      printf(1, "  L%d\t%d\n", i, st->slices[i]);
+  printf(1, "demotions %d, boosts %d\n", st->demotions, st->boosts);
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct schedstat st;
+  int i, pid;
+
+  if(argc == 1){
+    if(getSchedStat(0, &st) < 0){
+      printf(2, "schedstat: cannot read counters\n");
+      exit();
+    }
+    print(&st);
+    exit();
+  }
+  for(i = 1; i < argc; i++){
+    pid = atoi(argv[i]);
+    if(pid <= 0 || getSchedStat(pid, &st) < 0){
+      printf(2, "schedstat: no process %s\n", argv[i]);
+      continue;
+    }
+    printf(1, "pid %d\n", pid);
+    print(&st);
+  }
+  exit();
+}
@@ -6,6 +6,7 @@
 #include "x86.h"
 #include "memlayout.h"
 #include "mmu.h"
+#include "mlfq.h"
 #include "proc.h"
 #include "spinlock.h"
 #include "sleeplock.h"
@@ -16,6 +17,7 @@ initsleeplock(struct sleeplock *lk, char *name)
   initlock(&lk->lk, "sleep lock");
   lk->name = name;
   lk->locked = 0;
+  lk->holder = 0;
   lk->pid = 0;
 }
 
@@ -24,9 +26,12 @@ acquiresleep(struct sleeplock *lk)
 {
   acquire(&lk->lk);
   while (lk->locked) {
+    inheritpriority(lk);
     sleep(lk, &lk->lk);
   }
+  myproc()->waitlock = 0;
   lk->locked = 1;
+  lk->holder = myproc();
   lk->pid = myproc()->pid;
   release(&lk->lk);
 }
@@ -34,11 +39,17 @@ acquiresleep(struct sleeplock *lk)
 void
 releasesleep(struct sleeplock *lk)
 {
+  struct proc *p;
+
   acquire(&lk->lk);
+  p = lk->holder;
   lk->locked = 0;
+  lk->holder = 0;
   lk->pid = 0;
   wakeup(lk);
   release(&lk->lk);
+  if (p)
+    disinheritpriority(p);
 }
 
 int
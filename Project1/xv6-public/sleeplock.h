@@ -2,6 +2,7 @@
 struct sleeplock {
   uint locked;       // Is the lock held?
   struct spinlock lk; // spinlock protecting this sleep lock
+  struct proc *holder; // Process holding lock, lent its waiters' priority
   
   // For debugging:
   char *name;        // Name of lock.
@@ -6,6 +6,7 @@
 #include "x86.h"
 #include "memlayout.h"
 #include "mmu.h"
+#include "mlfq.h"
 #include "proc.h"
 #include "spinlock.h"
 
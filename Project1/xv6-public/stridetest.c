@@ -0,0 +1,83 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "mlfq.h"
+
+// Fairness benchmark for the stride-scheduled last level.
+//   stridetest [ticks]
+// Runs one spinning child per priority on a single stride-scheduled
+// level for ticks timer ticks (default 10000) and compares each child's
+// share of the time slices with its share of the tickets. Shares are
+// kept per cpu, so every child is pinned to cpu 0.
+
+#define NCHILD 4
+#define TOLERANCE 30  // per mille
+
+int
+main(int argc, char *argv[])
+{
+  struct mlfqpolicy pol, old;
+  struct schedstat st;
+  int pid[NCHILD], start[NCHILD], ran[NCHILD];
+  int i, n, total, tickets, share, want, err, maxerr;
+
+  n = argc > 1 ? atoi(argv[1]) : 10000;
+
+  memset(&pol, 0, sizeof(pol));
+  pol.nlevel = 1;
+  pol.quantum[0] = 1;
+  pol.boostperiod = 0;
+  pol.demote = MLFQ_DEMOTE_NONE;
+  pol.lastlevel = MLFQ_LAST_STRIDE;
+  if(setMLFQPolicy(&pol, &old) < 0){
+    printf(2, "stridetest: cannot set policy\n");
+    exit();
+  }
+
+  for(i = 0; i < NCHILD; i++){
+    if((pid[i] = fork()) == 0)
+      for(;;)
+        ;
+    setAffinity(pid[i], 1);
+    setPriority(pid[i], i);
+  }
+  for(i = 0; i < NCHILD; i++){
+    getSchedStat(pid[i], &st);
+    start[i] = st.slices[0];
+  }
+  sleep(n);
+  total = 0;
+  for(i = 0; i < NCHILD; i++){
+    getSchedStat(pid[i], &st);
+    ran[i] = st.slices[0] - start[i];
+    total += ran[i];
+  }
+  for(i = 0; i < NCHILD; i++){
+    kill(pid[i]);
+    wait();
+  }
+  setMLFQPolicy(&old, 0);
+
+  if(total == 0){
+    printf(2, "stridetest: children never ran\n");
+    exit();
+  }
+  tickets = 0;
+  for(i = 0; i < NCHILD; i++)
+    tickets += 1 << (NCHILD - 1 - i);
+  printf(1, "%d slices in %d ticks\n", total, n);
+  printf(1, "prio\ttickets\tslices\tshare\twant (per mille)\n");
+  maxerr = 0;
+  for(i = 0; i < NCHILD; i++){
+    share = ran[i] * 1000 / total;
+    want = (1 << (NCHILD - 1 - i)) * 1000 / tickets;
+    err = share > want ? share - want : want - share;
+    if(err > maxerr)
+      maxerr = err;
+    printf(1, "%d\t%d\t%d\t%d\t%d\n", i, 1 << (NCHILD - 1 - i), ran[i],
+           share, want);
+  }
+  printf(1, "max error %d per mille: %s\n", maxerr,
+         maxerr <= TOLERANCE ? "OK" : "FAIL");
+  exit();
+}
@@ -3,6 +3,7 @@
 #include "param.h"
 #include "memlayout.h"
 #include "mmu.h"
+#include "mlfq.h"
 #include "proc.h"
 #include "x86.h"
 #include "syscall.h"
@@ -13,6 +14,21 @@
 // library system call function. The saved user %esp points
 // to a saved program counter, and then the first argument.
 
+// Fault in n bytes at addr of the current process, which the caller
+// has checked, before the kernel uses them. Kills the process if there
+// is no memory for them.
+static int
+touch(uint addr, uint n)
+{
+  struct proc *curproc = myproc();
+
+  if(uvmtouch(curproc->pgdir, curproc->sz, addr, n) < 0){
+    curproc->killed = 1;
+    return -1;
+  }
+  return 0;
+}
+
 // Fetch the int at addr from the current process.
 int
 fetchint(uint addr, int *ip)
@@ -21,6 +37,8 @@ fetchint(uint addr, int *ip)
 
   if(addr >= curproc->sz || addr+4 > curproc->sz)
     return -1;
+  if(touch(addr, 4) < 0)
+    return -1;
   *ip = *(int*)(addr);
   return 0;
 }
@@ -39,6 +57,8 @@ fetchstr(uint addr, char **pp)
   *pp = (char*)addr;
   ep = (char*)curproc->sz;
   for(s = *pp; s < ep; s++){
+    if((s == *pp || (uint)s % PGSIZE == 0) && touch((uint)s, 1) < 0)
+      return -1;
     if(*s == 0)
       return s - *pp;
   }
@@ -65,6 +85,8 @@ argptr(int n, char **pp, int size)
     return -1;
   if(size < 0 || (uint)i >= curproc->sz || (uint)i+size > curproc->sz)
     return -1;
+  if(touch(i, size) < 0)
+    return -1;
   *pp = (char*)i;
   return 0;
 }
@@ -107,8 +129,11 @@ extern int sys_myfunction(void);
 extern int sys_yield(void);
 extern int sys_getLevel(void);
 extern int sys_setPriority(void);
-extern int sys_schedulerLock(void);
-extern int sys_schedulerUnlock(void);
+extern int sys_setReservation(void);
+extern int sys_setMLFQPolicy(void);
+extern int sys_getSchedStat(void);
+extern int sys_setAffinity(void);
+extern int sys_yield_to(void);
 
 static int (*syscalls[])(void) = {
 [SYS_fork]    sys_fork,
@@ -136,8 +161,11 @@ static int (*syscalls[])(void) = {
 [SYS_yield] sys_yield,
 [SYS_getLevel] sys_getLevel,
 [SYS_setPriority] sys_setPriority,
-[SYS_schedulerLock] sys_schedulerLock,
-[SYS_schedulerUnlock] sys_schedulerUnlock,
+[SYS_setReservation] sys_setReservation,
+[SYS_setMLFQPolicy] sys_setMLFQPolicy,
+[SYS_getSchedStat] sys_getSchedStat,
+[SYS_setAffinity] sys_setAffinity,
+[SYS_yield_to] sys_yield_to,
 };
 
 void
@@ -24,5 +24,8 @@
 #define SYS_yield 23
 #define SYS_getLevel 24
 #define SYS_setPriority 25
-#define SYS_schedulerLock 26
-#define SYS_schedulerUnlock 27
\ No newline at end of file
+#define SYS_setReservation 26
+#define SYS_setMLFQPolicy 27
+#define SYS_getSchedStat 28
+#define SYS_setAffinity 29
+#define SYS_yield_to 30
\ No newline at end of file
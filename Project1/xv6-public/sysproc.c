@@ -5,6 +5,7 @@
 #include "param.h"
 #include "memlayout.h"
 #include "mmu.h"
+#include "mlfq.h"
 #include "proc.h"
 
 int
@@ -71,6 +72,7 @@ sys_sleep(void)
       release(&tickslock);
       return -1;
     }
+    sleepuntil(ticks0 + n);
     sleep(&ticks, &tickslock);
   }
   release(&tickslock);
@@ -111,20 +113,59 @@ int sys_setPriority(void) {
   return 1;
 }
 
-int sys_schedulerLock() {
-  int password;
-  if (argint(0,&password)<0) {
+int sys_setAffinity(void) {
+  int pid, mask;
+  if (argint(0, &pid) < 0 || argint(1, &mask) < 0)
     return -1;
-  }
-  schedulerLock(password);
-  return 1;
+  return setAffinity(pid, mask);
+}
+
+int sys_yield_to(void) {
+  int pid;
+  if (argint(0, &pid) < 0)
+    return -1;
+  return yield_to(pid);
 }
 
-int sys_schedulerUnlock() {
-  int password;
-  if (argint(0,&password)<0) {
+int sys_setReservation(void) {
+  int pid, budget, period;
+  if (argint(0, &pid) < 0 || argint(1, &budget) < 0 || argint(2, &period) < 0)
     return -1;
+  return setReservation(pid, budget, period);
+}
+
+// setMLFQPolicy(new, old): either pointer may be 0. Copies go through
+// kernel locals so no user memory is touched under ptable.lock.
+int sys_setMLFQPolicy(void) {
+  int newp, oldp;
+  char *p;
+  struct mlfqpolicy np, old;
+
+  if (argint(0, &newp) < 0 || argint(1, &oldp) < 0)
+    return -1;
+  if (newp) {
+    if (argptr(0, &p, sizeof(np)) < 0)
+      return -1;
+    memmove(&np, p, sizeof(np));
   }
-  schedulerUnlock(password);
-  return 1;
-}
\ No newline at end of file
+  if (oldp && argptr(1, &p, sizeof(old)) < 0)
+    return -1;
+  if (setMLFQPolicy(newp ? &np : 0, &old) < 0)
+    return -1;
+  if (oldp)
+    memmove((char*)oldp, &old, sizeof(old));
+  return 0;
+}
+
+int sys_getSchedStat(void) {
+  int pid;
+  char *p;
+  struct schedstat st;
+
+  if (argint(0, &pid) < 0 || argptr(1, &p, sizeof(st)) < 0)
+    return -1;
+  if (getSchedStat(pid, &st) < 0)
+    return -1;
+  memmove(p, &st, sizeof(st));
+  return 0;
+}
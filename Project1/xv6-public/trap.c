@@ -3,6 +3,7 @@
 #include "param.h"
 #include "memlayout.h"
 #include "mmu.h"
+#include "mlfq.h"
 #include "proc.h"
 #include "x86.h"
 #include "traps.h"
@@ -12,8 +13,8 @@
 struct gatedesc idt[256];
 extern uint vectors[]; // in vectors.S: array of 256 entry pointers
 struct spinlock tickslock;
-extern int isLocked;
 uint ticks;
+static uint nextwake = ~0; // earliest tick a sleep() caller waits for
 
 void tvinit(void)
 {
@@ -22,8 +23,6 @@ void tvinit(void)
   for (i = 0; i < 256; i++)
     SETGATE(idt[i], 0, SEG_KCODE << 3, vectors[i], 0);
   SETGATE(idt[T_SYSCALL], 1, SEG_KCODE << 3, vectors[T_SYSCALL], DPL_USER);
-  SETGATE(idt[129], 1, SEG_KCODE << 3, vectors[129], DPL_USER);
-  SETGATE(idt[130], 1, SEG_KCODE << 3, vectors[130], DPL_USER);
 
   initlock(&tickslock, "time");
 }
@@ -33,41 +32,97 @@ void idtinit(void)
   lidt(idt, sizeof(idt));
 }
 
+// Advance the clock by n ticks. Only cpu0 keeps time.
+// Sleepers are woken only once the earliest deadline passes.
+void clockadvance(uint n)
+{
+  acquire(&tickslock);
+  ticks += n;
+  if (ticks >= rtdeadline())
+    rtreplenish();
+  if (ticks >= nextwake)
+  {
+    nextwake = ~0; // 깨어난 애들이 다시 deadline을 등록한다.
+    wakeup(&ticks);
+  }
+  release(&tickslock);
+}
+
+// Ticks until cpu0 next has to advance the clock for someone: the
+// earliest sleep() deadline or real-time budget refill.
+// 0 if nothing is waiting on the clock.
+uint clockdeadline(void)
+{
+  uint n = 0, rt;
+
+  acquire(&tickslock);
+  if (nextwake != ~0)
+    n = nextwake > ticks ? nextwake - ticks : 1;
+  rt = rtdeadline();
+  if (rt != ~0)
+  {
+    rt = rt > ticks ? rt - ticks : 1;
+    if (n == 0 || rt < n)
+      n = rt;
+  }
+  release(&tickslock);
+  return n;
+}
+
+// Note that a sleep() caller wants waking at tick deadline.
+// If cpu0 is idle on a later deadline, kick it to re-arm its timer.
+// Caller holds tickslock.
+void sleepuntil(uint deadline)
+{
+  if (deadline >= nextwake)
+    return;
+  nextwake = deadline;
+  __sync_synchronize();
+  if (cpus[0].idle)
+    wakecpu(0);
+}
+
 // PAGEBREAK: 41
 void trap(struct trapframe *tf)
 {
+  struct cpu *c;
+  struct proc *handoff;
+  int handoffpid;
+
   if (tf->trapno == T_SYSCALL)
   {
     if (myproc()->killed)
       exit();
+    // A handoff is only good within the system call that woke it.
+    pushcli();
+    mycpu()->handoff = 0;
+    popcli();
     myproc()->tf = tf;
     syscall();
     if (myproc()->killed)
       exit();
     return;
   }
+  // Whoever an interrupt wakes was not woken by the process it happened
+  // to interrupt, so that process keeps the handoff it had (see sched()).
+  c = mycpu();
+  handoff = c->handoff;
+  handoffpid = c->handoffpid;
   switch (tf->trapno)
   {
-  case 129:
-    schedulerLock(2019073181);
-    break;
-  case 130:
-    schedulerUnlock(2019073181);
-    break;
   case T_IRQ0 + IRQ_TIMER:
-    if (cpuid() == 0)
+    if (mycpu()->tickless) // idle cpu woke up; scheduler() counts the ticks it slept
     {
-      acquire(&tickslock);
-      ticks++;
-      if (ticks >= 100)
-      {
-        isLocked = 0;        // global tick 100되면 풀어줘야함.
-        ticks = 0;           // tick 초기화
-        priority_boosting(); // priority boosting호출
-      }
-      wakeup(&ticks);
-      release(&tickslock);
+      lapiceoi();
+      break;
     }
+    lapicperiodic(); // back from an early wake out of idle()
+    if (cpuid() == 0)
+      clockadvance(1);
+    mlfq_tick(1); // 각 CPU가 자기 큐를 priority boosting
+    lapiceoi();
+    break;
+  case T_IRQ0 + IRQ_WAKEUP:
     lapiceoi();
     break;
   case T_IRQ0 + IRQ_IDE:
@@ -91,6 +146,17 @@ void trap(struct trapframe *tf)
             cpuid(), tf->cs, tf->eip);
     lapiceoi();
     break;
+  case T_PGFLT:
+    // Heap that sbrk made room for but nothing has touched yet (see
+    // lazyfault), or a write to a page shared copy-on-write since fork
+    // (see copyuvm). System calls fault in the user memory they use
+    // beforehand (see argptr), so in the kernel it is the latter.
+    if (myproc() && !(tf->err & 1) &&
+        lazyfault(myproc()->pgdir, myproc()->sz, rcr2()) == 0)
+      break;
+    if (myproc() && (tf->err & 2) && cowfault(myproc()->pgdir, rcr2()) == 0)
+      break;
+    // fall through
 
   // PAGEBREAK: 13
   default:
@@ -108,6 +174,8 @@ void trap(struct trapframe *tf)
             tf->err, cpuid(), tf->eip, rcr2());
     myproc()->killed = 1;
   }
+  c->handoff = handoff;
+  c->handoffpid = handoffpid;
 
   // Force process exit if it has been killed and is in user space.
   // (If it is still executing in the kernel, let it keep running
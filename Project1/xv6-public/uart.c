@@ -9,6 +9,7 @@
 #include "fs.h"
 #include "file.h"
 #include "mmu.h"
+#include "mlfq.h"
 #include "proc.h"
 #include "x86.h"
 
@@ -1,4 +1,6 @@
 struct stat;
+struct mlfqpolicy;
+struct schedstat;
 struct rtcdate;
 
 // system calls
@@ -27,8 +29,11 @@ int myfunction(char*);
 void yield(void);
 int getLevel(void);
 void setPriority(int, int);
-void schedulerLock(int);
-void schedulerUnlock(int);
+int setReservation(int, int, int);
+int setMLFQPolicy(struct mlfqpolicy*, struct mlfqpolicy*);
+int getSchedStat(int, struct schedstat*);
+int setAffinity(int, int);
+int yield_to(int);
 
 // ulib.c
 int stat(const char*, struct stat*);
@@ -8,6 +8,7 @@ struct rtcdate;
 struct spinlock;
 struct sleeplock;
 struct stat;
+struct pstat;
 struct superblock;
 
 // bio.c
@@ -69,6 +70,8 @@ char *kalloc(void);
 void kfree(char *);
 void kinit1(void *, void *);
 void kinit2(void *, void *);
+void kincref(char *);
+int krefcount(char *);
 
 // kbd.c
 void kbdintr(void);
@@ -79,6 +82,7 @@ int lapicid(void);
 extern volatile uint *lapic;
 void lapiceoi(void);
 void lapicinit(void);
+void lapicipi(uchar, int);
 void lapicstartap(uchar, uint);
 void microdelay(int);
 
@@ -109,8 +113,14 @@ void exit(void);
 int fork(void);
 int growproc(int);
 int kill(int);
+int killothers(void);
+void tlbshootdown(struct proc *);
+void tlbpoll(void);
+void cowflush(struct proc *);
+int heapfault(uint, int);
 struct cpu *mycpu(void);
 struct proc *myproc();
+struct thread *mythread(void);
 void pinit(void);
 void procdump(void);
 void scheduler(void) __attribute__((noreturn));
@@ -122,10 +132,14 @@ int wait(void);
 void wakeup(void *);
 void yield(void);
 int setmemorylimit(int, int);
+int setmemorysoftlimit(int, int);
 int thread_create(thread_t *thread, void *(*)(void *), void *);
 void thread_exit(void *);
 int thread_join(thread_t, void **);
 void list_info(void);
+int procinfo(struct pstat *, int);
+int futex_wait(int *, int);
+int futex_wake(int *, int);
 
 // swtch.S
 void swtch(struct context **, struct context *);
@@ -183,11 +197,17 @@ pde_t *setupkvm(void);
 char *uva2ka(pde_t *, char *);
 int allocuvm(pde_t *, uint, uint);
 int deallocuvm(pde_t *, uint, uint);
+int unmapuvm(pde_t *, uint, uint, char **);
+uint uvmpages(pde_t *);
+uint uvmgrowth(pde_t *, uint, uint);
+int tlsinit(pde_t *, uint, uint);
 void freevm(pde_t *);
 void inituvm(pde_t *, char *, uint);
 int loaduvm(pde_t *, char *, struct inode *, uint, uint);
 pde_t *copyuvm(pde_t *, uint);
-void switchuvm(struct proc *);
+int cowfault(pde_t *, uint);
+int lazyfault(pde_t *, uint, uint);
+void switchuvm(struct thread *);
 void switchkvm(void);
 int copyout(pde_t *, uint, void *, uint);
 void clearpteu(pde_t *pgdir, char *uva);
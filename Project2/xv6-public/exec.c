@@ -11,14 +11,12 @@ int exec(char *path, char **argv)
 {
   char *s, *last;
   int i, off;
-  uint argc, sz, sp, ustack[3 + MAXARG + 1];
+  uint argc, sz, sp, rss, ustack[3 + MAXARG + 1];
   struct elfhdr elf;
   struct inode *ip;
   struct proghdr ph;
   pde_t *pgdir, *oldpgdir;
   struct proc *curproc = myproc();
-  struct thread *t;
-  uint idx = 0;
   begin_op();
   // path인수가 유효한 파일인지 확인 아니면 -1 리턴
   if ((ip = namei(path)) == 0)
@@ -52,27 +50,8 @@ int exec(char *path, char **argv)
       goto bad;
     if (ph.vaddr + ph.memsz < ph.vaddr)
       goto bad;
-    if (curproc->limit == 0) // unlimied 상태
-    {
-      if ((sz = allocuvm(pgdir, sz, ph.vaddr + ph.memsz)) == 0)
-      {
-        goto bad;
-      }
-    }
-    else if (curproc->limit != 0)
-    {
-      if (curproc->limit >= ph.vaddr + ph.memsz) // 할당해도 되는지 검사
-      {
-        if ((sz = allocuvm(pgdir, sz, ph.vaddr + ph.memsz)) == 0)
-        {
-          goto bad;
-        }
-      }
-      else
-      {
-        goto bad;
-      }
-    }
+    if ((sz = allocuvm(pgdir, sz, ph.vaddr + ph.memsz)) == 0)
+      goto bad;
     if (ph.vaddr % PGSIZE != 0)
       goto bad;
     if (loaduvm(pgdir, (char *)ph.vaddr, ip, ph.off, ph.filesz) < 0)
@@ -85,29 +64,18 @@ int exec(char *path, char **argv)
   // Make the first inaccessible.  Use the second as the user stack.
   // 새 프로세스의 스택을 설정 / 스택에 대해 두 페이지의 메모리를 할당. 첫번째 페이지는 ACCESS불가, 두번째 페이지는 스택사용
   sz = PGROUNDUP(sz);
-  if (curproc->limit == 0) // unlimied 상태
-  {
-    if ((sz = allocuvm(pgdir, sz, sz + 2 * PGSIZE)) == 0)
-    {
-      goto bad;
-    }
-  }
-  else if (curproc->limit != 0)
-  {
-    if (curproc->limit >= sz + 2 * PGSIZE) // 할당해도 되는지 검사
-    {
-      if ((sz = allocuvm(pgdir, sz, sz + 2 * PGSIZE)) == 0)
-      {
-        goto bad;
-      }
-    }
-    else
-    {
-      goto bad;
-    }
-  }
+  if ((sz = allocuvm(pgdir, sz, sz + 2 * PGSIZE)) == 0)
+    goto bad;
+  // 페이지 테이블까지 센 새 주소 공간과 이 쓰레드의 커널 스택이
+  // 하드 제한 안에 들어야 한다.
+  rss = uvmpages(pgdir);
+  if (curproc->limit != 0 && (rss + 1) * PGSIZE > (uint)curproc->limit)
+    goto bad;
   clearpteu(pgdir, (char *)(sz - 2 * PGSIZE));
-  sp = sz;
+  // 스택 맨 위는 메인 쓰레드의 TLS 블록이다.
+  if (tlsinit(pgdir, sz - TLSSIZE, mythread()->tid) < 0)
+    goto bad;
+  sp = sz - TLSSIZE;
 
   // Push argument strings, prepare rest of stack in ustack.
   // 새 프로세스에 대한 인수를 스택에 푸시. exec()함수는 copyout()함수를 사용하여 인수를 사용자 공간에서 커널 공간으로 복사
@@ -130,44 +98,29 @@ int exec(char *path, char **argv)
   if (copyout(pgdir, sp, ustack, (3 + argc + 1) * 4) < 0)
     goto bad;
 
+  // Commit to the user image.
+  // 다른 쓰레드들은 옛 주소 공간에서 돌고 있으므로 먼저 모두 끝내고,
+  // exec을 부른 쓰레드만 남아 새 프로그램을 실행한다.
+  // 이미 죽는 중이라면 exec은 실패하고 이 쓰레드도 끝난다.
+  if (killothers() < 0)
+    goto bad;
+
   // Save program name for debugging.
   for (last = s = path; *s; s++)
     if (*s == '/')
       last = s + 1;
   safestrcpy(curproc->name, last, sizeof(curproc->name));
 
-  // Commit to the user image.
   // exec함수는 프로그램 카운터를 새 프로세스의 main함수의 주소로 설정.
   oldpgdir = curproc->pgdir;
   curproc->pgdir = pgdir;
   curproc->sz = sz;
-  curproc->tf->eip = elf.entry; // main
-  curproc->tf->esp = sp;
-  switchuvm(curproc);
-  if (curproc->curThrIdx != 0) // 현재 돌고있는 번호가 0번(메인 쓰레드)이 아닌 그냥 일반 쓰레드일 때
-  {
-    curproc->thrlist.thread[curproc->curThrIdx].execVisited = 1;                        // execVisited를 1로 설정
-    curproc->thrlist.thread[0].chan = curproc->thrlist.thread[curproc->curThrIdx].chan; // chan, retval, thr_state 변경
-    curproc->thrlist.thread[0].retval = curproc->thrlist.thread[curproc->curThrIdx].retval;
-    curproc->thrlist.thread[0].thr_state = curproc->thrlist.thread[curproc->curThrIdx].thr_state;
-  }
-  // kill part
-  for (idx = 0, t = curproc->thrlist.thread; t < &curproc->thrlist.thread[NTHR]; idx++, t++)
-  {
-    if (idx == curproc->curThrIdx || idx == 0) // idx가 0(메인쓰레드)거나 현재 쓰레드 번호일 때는 정보 남겨둔다.
-      continue;
-    if (t->kstack != 0)
-    {
-      kfree(t->kstack);
-    }
-
-    t->kstack = 0;
-    t->context = 0;
-    t->thr_state = THR_UNUSED;
-    t->tid = 0;
-    t->chan = 0;
-    t->tf = 0;
-  }
+  curproc->rss = rss;
+  mythread()->tf->eip = elf.entry; // main
+  mythread()->tf->esp = sp;
+  mythread()->tf->gs = (SEG_UTLS << 3) | DPL_USER;
+  mythread()->tls = sz - TLSSIZE;
+  switchuvm(mythread());
   freevm(oldpgdir);
   return 0;
 
@@ -186,7 +139,7 @@ int exec2(char *path, char **argv, int stacksize)
 {
   char *s, *last;
   int i, off;
-  uint argc, sz, sp, ustack[3 + MAXARG + 1];
+  uint argc, sz, sp, rss, ustack[3 + MAXARG + 1];
   struct elfhdr elf;
   struct inode *ip;
   struct proghdr ph;
@@ -231,27 +184,8 @@ int exec2(char *path, char **argv, int stacksize)
       goto bad;
     if (ph.vaddr + ph.memsz < ph.vaddr)
       goto bad;
-    if (curproc->limit == 0) // unlimied 상태
-    {
-      if ((sz = allocuvm(pgdir, sz, ph.vaddr + ph.memsz)) == 0)
-      {
-        goto bad;
-      }
-    }
-    else if (curproc->limit != 0)
-    {
-      if (curproc->limit >= ph.vaddr + ph.memsz) // 할당해도 되는지 검사
-      {
-        if ((sz = allocuvm(pgdir, sz, ph.vaddr + ph.memsz)) == 0)
-        {
-          goto bad;
-        }
-      }
-      else
-      {
-        goto bad;
-      }
-    }
+    if ((sz = allocuvm(pgdir, sz, ph.vaddr + ph.memsz)) == 0)
+      goto bad;
     if (ph.vaddr % PGSIZE != 0)
       goto bad;
     if (loaduvm(pgdir, (char *)ph.vaddr, ip, ph.off, ph.filesz) < 0)
@@ -264,29 +198,18 @@ int exec2(char *path, char **argv, int stacksize)
   // Allocate two pages at the next page boundary.
   // Make the first inaccessible. Use the second as the user stack.
   sz = PGROUNDUP(sz);
-  if (curproc->limit == 0) // unlimied 상태
-  {
-    if ((sz = allocuvm(pgdir, sz, sz + (stacksize + 1) * PGSIZE)) == 0)
-    {
-      goto bad;
-    }
-  }
-  else if (curproc->limit != 0)
-  {
-    if (curproc->limit >= sz + (stacksize+1) * PGSIZE) // 할당해도 되는지 검사
-    {
-      if ((sz = allocuvm(pgdir, sz, sz + (stacksize + 1) * PGSIZE)) == 0)
-      {
-        goto bad;
-      }
-    }
-    else
-    {
-      goto bad;
-    }
-  }
+  if ((sz = allocuvm(pgdir, sz, sz + (stacksize + 1) * PGSIZE)) == 0)
+    goto bad;
+  // 페이지 테이블까지 센 새 주소 공간과 이 쓰레드의 커널 스택이
+  // 하드 제한 안에 들어야 한다.
+  rss = uvmpages(pgdir);
+  if (curproc->limit != 0 && (rss + 1) * PGSIZE > (uint)curproc->limit)
+    goto bad;
   clearpteu(pgdir, (char *)(sz - (stacksize + 1) * PGSIZE));
-  sp = sz;
+  // 스택 맨 위는 메인 쓰레드의 TLS 블록이다.
+  if (tlsinit(pgdir, sz - TLSSIZE, mythread()->tid) < 0)
+    goto bad;
+  sp = sz - TLSSIZE;
 
   // Push argument strings, prepare rest of stack in ustack.
   for (argc = 0; argv[argc]; argc++)
@@ -308,19 +231,25 @@ int exec2(char *path, char **argv, int stacksize)
   if (copyout(pgdir, sp, ustack, (3 + argc + 1) * 4) < 0)
     goto bad;
 
+  // Commit to the user image.
+  if (killothers() < 0)
+    goto bad;
+
   // Save program name for debugging.
   for (last = s = path; *s; s++)
     if (*s == '/')
       last = s + 1;
   safestrcpy(curproc->name, last, sizeof(curproc->name));
 
-  // Commit to the user image.
   oldpgdir = curproc->pgdir;
   curproc->pgdir = pgdir;
   curproc->sz = sz;
-  curproc->tf->eip = elf.entry; // main
-  curproc->tf->esp = sp;
-  switchuvm(curproc);
+  curproc->rss = rss;
+  mythread()->tf->eip = elf.entry; // main
+  mythread()->tf->esp = sp;
+  mythread()->tf->gs = (SEG_UTLS << 3) | DPL_USER;
+  mythread()->tls = sz - TLSSIZE;
+  switchuvm(mythread());
   freevm(oldpgdir);
   return 0;
 
@@ -120,6 +120,16 @@ microdelay(int us)
 {
 }
 
+// Send interrupt vector to the cpu whose local APIC ID is apicid.
+void
+lapicipi(uchar apicid, int vector)
+{
+  lapicw(ICRHI, apicid<<24);
+  lapicw(ICRLO, FIXED | ASSERT | vector);
+  while(lapic[ICRLO] & DELIVS)
+    ;
+}
+
 #define CMOS_PORT    0x70
 #define CMOS_RETURN  0x71
 
@@ -0,0 +1,198 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+// Allocator benchmark for threaded processes.
+//   mallocbench [maxthread] [ops]
+// For 1, 2, ... maxthread threads (default 8), each thread does ops
+// (default 20000) random malloc/free pairs of 16 to 512 bytes over a
+// window of live blocks, first with malloc/free and then with the
+// K&R allocator this library used to have, made safe for threads with
+// one mutex. Prints the ticks each took.
+
+#define MAXTHREAD 16
+#define WINDOW 64
+
+int nthread;
+int ops;
+int useold;
+
+// The previous umalloc.c, renamed, behind a single lock.
+
+typedef long Align;
+
+union header {
+  struct {
+    union header *ptr;
+    uint size;
+  } s;
+  Align x;
+};
+
+typedef union header Header;
+
+static Header base;
+static Header *freep;
+static mutex_t krlock;
+
+static void
+krfree1(void *ap)
+{
+  Header *bp, *p;
+
+  bp = (Header*)ap - 1;
+  for(p = freep; !(bp > p && bp < p->s.ptr); p = p->s.ptr)
+    if(p >= p->s.ptr && (bp > p || bp < p->s.ptr))
+      break;
+  if(bp + bp->s.size == p->s.ptr){
+    bp->s.size += p->s.ptr->s.size;
+    bp->s.ptr = p->s.ptr->s.ptr;
+  } else
+    bp->s.ptr = p->s.ptr;
+  if(p + p->s.size == bp){
+    p->s.size += bp->s.size;
+    p->s.ptr = bp->s.ptr;
+  } else
+    p->s.ptr = bp;
+  freep = p;
+}
+
+static Header*
+morecore(uint nu)
+{
+  char *p;
+  Header *hp;
+
+  if(nu < 4096)
+    nu = 4096;
+  p = sbrk(nu * sizeof(Header));
+  if(p == (char*)-1)
+    return 0;
+  hp = (Header*)p;
+  hp->s.size = nu;
+  krfree1((void*)(hp + 1));
+  return freep;
+}
+
+void
+krfree(void *ap)
+{
+  mutex_lock(&krlock);
+  krfree1(ap);
+  mutex_unlock(&krlock);
+}
+
+void*
+krmalloc(uint nbytes)
+{
+  Header *p, *prevp;
+  uint nunits;
+
+  mutex_lock(&krlock);
+  nunits = (nbytes + sizeof(Header) - 1)/sizeof(Header) + 1;
+  if((prevp = freep) == 0){
+    base.s.ptr = freep = prevp = &base;
+    base.s.size = 0;
+  }
+  for(p = prevp->s.ptr; ; prevp = p, p = p->s.ptr){
+    if(p->s.size >= nunits){
+      if(p->s.size == nunits)
+        prevp->s.ptr = p->s.ptr;
+      else {
+        p->s.size -= nunits;
+        p += p->s.size;
+        p->s.size = nunits;
+      }
+      freep = prevp;
+      mutex_unlock(&krlock);
+      return (void*)(p + 1);
+    }
+    if(p == freep)
+      if((p = morecore(nunits)) == 0){
+        mutex_unlock(&krlock);
+        return 0;
+      }
+  }
+}
+
+void*
+churn(void *arg)
+{
+  char *live[WINDOW];
+  uint seed, size;
+  int i, k;
+
+  memset(live, 0, sizeof(live));
+  seed = (uint)arg * 2654435761u + 1;
+  for(i = 0; i < ops; i++){
+    seed = seed * 1103515245 + 12345;
+    k = (seed >> 16) % WINDOW;
+    size = 16 + (seed >> 8) % 497;
+    if(useold){
+      krfree(live[k]);
+      live[k] = krmalloc(size);
+    } else {
+      free(live[k]);
+      live[k] = malloc(size);
+    }
+    if(live[k] == 0){
+      printf(2, "mallocbench: out of memory\n");
+      exit();
+    }
+    live[k][0] = i;
+    live[k][size - 1] = i;
+  }
+  for(k = 0; k < WINDOW; k++){
+    if(live[k] == 0)
+      continue;
+    if(useold)
+      krfree(live[k]);
+    else
+      free(live[k]);
+  }
+  thread_exit(0);
+  return 0;
+}
+
+int
+run(int k)
+{
+  thread_t tid[MAXTHREAD];
+  void *ret;
+  int i, t0;
+
+  nthread = k;
+  t0 = uptime();
+  for(i = 0; i < k; i++){
+    if(thread_create(&tid[i], churn, (void*)i) < 0){
+      printf(2, "mallocbench: thread_create failed\n");
+      exit();
+    }
+  }
+  for(i = 0; i < k; i++)
+    thread_join(tid[i], &ret);
+  return uptime() - t0;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int maxthread, k, tnew, told;
+
+  maxthread = argc > 1 ? atoi(argv[1]) : 8;
+  ops = argc > 2 ? atoi(argv[2]) : 20000;
+  if(maxthread < 1 || maxthread > MAXTHREAD || ops < 1){
+    printf(2, "usage: mallocbench [maxthread (1-%d)] [ops]\n", MAXTHREAD);
+    exit();
+  }
+  printf(1, "%d malloc/free pairs per thread\n", ops);
+  printf(1, "threads\tmalloc\tk&r+lock (ticks)\n");
+  for(k = 1; k <= maxthread; k++){
+    useold = 0;
+    tnew = run(k);
+    useold = 1;
+    told = run(k);
+    printf(1, "%d\t%d\t%d\n", k, tnew, told);
+  }
+  exit();
+}
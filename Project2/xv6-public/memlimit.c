@@ -0,0 +1,166 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define NUM_THREAD 8
+#define PGSIZE 4096
+
+thread_t thread[NUM_THREAD];
+
+void failed()
+{
+  printf(1, "Test failed!\n");
+  exit();
+}
+
+void *thread_nop(void *arg)
+{
+  thread_exit(arg);
+  return 0;
+}
+
+// 쓰레드를 만들고 join해서 스택 풀에 스택을 남긴다.
+void fill_pool(void)
+{
+  int i;
+  void *retval;
+  for (i = 0; i < NUM_THREAD; i++) {
+    if (thread_create(&thread[i], thread_nop, (void *)i) != 0) {
+      printf(1, "Error creating thread %d\n", i);
+      failed();
+    }
+  }
+  for (i = 0; i < NUM_THREAD; i++) {
+    if (thread_join(thread[i], &retval) != 0) {
+      printf(1, "Error joining thread %d\n", i);
+      failed();
+    }
+  }
+}
+
+void one_thread(void)
+{
+  void *retval;
+  if (thread_create(&thread[0], thread_nop, 0) != 0 ||
+      thread_join(thread[0], &retval) != 0) {
+    printf(1, "Error running a thread\n");
+    failed();
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  int pid, top, child, fd[2], i, n;
+  char *heap, c;
+
+  pid = getpid();
+
+  printf(1, "Test 1: Hard limit\n");
+  // 페이지 테이블과 커널 스택까지 세므로 sz만큼으로는 부족하다.
+  top = (int)sbrk(0);
+  if (setmemorylimit(pid, top) == 0) {
+    printf(1, "Limit below the resident size was accepted\n");
+    failed();
+  }
+  if (setmemorylimit(pid, top + 16 * PGSIZE) != 0) {
+    printf(1, "Error setting memory limit\n");
+    failed();
+  }
+  if (sbrk(32 * PGSIZE) != (char *)-1) {
+    printf(1, "sbrk went over the hard limit\n");
+    failed();
+  }
+  if (sbrk(4 * PGSIZE) == (char *)-1) {
+    printf(1, "sbrk under the hard limit failed\n");
+    failed();
+  }
+  sbrk(-4 * PGSIZE);
+  setmemorylimit(pid, 0);
+  printf(1, "Test 1 passed\n\n");
+
+  printf(1, "Test 2: Reclaim on hard limit\n");
+  // 풀에 남은 스택(쓰레드당 커널 스택 1, 유저 스택 2 페이지)은 회수되어야
+  // sz보다 조금 큰 제한이 받아들여진다.
+  fill_pool();
+  top = (int)sbrk(0);
+  if (setmemorylimit(pid, top + 4 * PGSIZE) != 0) {
+    printf(1, "Cached stacks were not reclaimed\n");
+    failed();
+  }
+  if (sbrk(8 * PGSIZE) == (char *)-1) {
+    printf(1, "Reclaimed stacks still count against the limit\n");
+    failed();
+  }
+  sbrk(-8 * PGSIZE);
+  setmemorylimit(pid, 0);
+  fill_pool();
+  printf(1, "Test 2 passed\n\n");
+
+  printf(1, "Test 3: Soft limit\n");
+  // 풀에 스택이 있으면 새 쓰레드는 주소 공간을 늘리지 않는다.
+  top = (int)sbrk(0);
+  one_thread();
+  if ((int)sbrk(0) != top) {
+    printf(1, "Thread did not reuse a cached stack\n");
+    failed();
+  }
+  // 소프트 제한을 넘으면 풀이 회수되므로 새 쓰레드는 스택을 새로 만든다.
+  if (setmemorysoftlimit(pid, PGSIZE) != 0) {
+    printf(1, "Error setting soft memory limit\n");
+    failed();
+  }
+  one_thread();
+  if ((int)sbrk(0) != top + 2 * PGSIZE) {
+    printf(1, "Soft limit did not reclaim the cached stacks\n");
+    failed();
+  }
+  // 할당 자체는 막지 않는다.
+  if (sbrk(32 * PGSIZE) == (char *)-1) {
+    printf(1, "sbrk failed under a soft limit only\n");
+    failed();
+  }
+  setmemorysoftlimit(pid, 0);
+  printf(1, "Test 3 passed\n\n");
+
+  printf(1, "Test 4: Hard limit on first touch\n");
+  // sbrk은 페이지를 바로 할당하지 않으므로, 제한은 처음 건드릴 때 검사한다.
+  if (pipe(fd) < 0) {
+    printf(1, "Pipe error\n");
+    failed();
+  }
+  child = fork();
+  if (child < 0) {
+    printf(1, "Fork error\n");
+    failed();
+  }
+  if (child == 0) {
+    close(fd[0]);
+    top = (int)sbrk(0);
+    heap = sbrk(16 * PGSIZE);
+    if (setmemorylimit(getpid(), top + 4 * PGSIZE) != 0) {
+      write(fd[1], "l", 1);
+      exit();
+    }
+    for (i = 0; i < 16 * PGSIZE; i += PGSIZE)
+      heap[i] = 1;
+    // 제한을 넘는 순간 죽어야 하므로 여기에 오면 안 된다.
+    write(fd[1], "x", 1);
+    exit();
+  }
+  close(fd[1]);
+  n = read(fd[0], &c, 1);
+  close(fd[0]);
+  wait();
+  if (n == 1 && c == 'l') {
+    printf(1, "Untouched heap counted against the limit\n");
+    failed();
+  }
+  if (n != 0) {
+    printf(1, "Touching the heap went over the hard limit\n");
+    failed();
+  }
+  printf(1, "Test 4 passed\n\n");
+
+  printf(1, "All tests passed!\n");
+  exit();
+}
@@ -1,10 +1,21 @@
 #include "types.h"
 #include "stat.h"
 #include "user.h"
+#include "param.h"
+#include "pstat.h"
 
 #define MAX_ARGS 16
 #define MAX_ARG_LEN 32
 
+// proc.h의 enum procstate, enum threadstate 순서
+char *pstates[] = {"unused", "embryo", "sleep", "runble", "run", "zombie"};
+char *tstates[] = {"unused", "embryo", "sleep", "runble", "run", "zombie"};
+
+// procinfo로 받은 스냅샷. top은 앞 스냅샷과 비교해 그 사이에 쓴 틱을 보여준다.
+struct pstat ps[NPROC];
+struct pstat prev[NPROC];
+int nprev;
+
 void parse_input(char *input, char **args, int *argc)
 {
   int i = 0;
@@ -44,6 +55,89 @@ void parse_input(char *input, char **args, int *argc)
   *argc = arg_cnt;
 }
 
+char *statename(char **names, int state)
+{
+  if (state < 0 || state > 5)
+    return "???";
+  return names[state];
+}
+
+// 프로세스마다 한 줄, -v면 그 아래에 쓰레드마다 한 줄씩 출력
+void print_list(int n, int verbose)
+{
+  int i, j;
+  struct tstat *t;
+
+  printf(1, "PID\tPPID\tSTATE\tTHR\tSZ\tRSS\tLIMIT\tSOFT\tTICKS\tSYSCALL\tNAME\n");
+  for (i = 0; i < n; i++)
+  {
+    printf(1, "%d\t%d\t%s\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%s%s\n",
+           ps[i].pid, ps[i].ppid, statename(pstates, ps[i].state), ps[i].nthread,
+           ps[i].sz, ps[i].rss * 4096, ps[i].limit, ps[i].softlimit,
+           ps[i].ticks, ps[i].nsyscall, ps[i].name, ps[i].killed ? " (killed)" : "");
+    if (!verbose)
+      continue;
+    for (j = 0; j < ps[i].nthread; j++)
+    {
+      t = &ps[i].thread[j];
+      printf(1, "  tid %d\t%s\tticks %d\tsyscalls %d\n",
+             t->tid, statename(tstates, t->state), t->ticks, t->nsyscall);
+    }
+  }
+}
+
+// 앞 스냅샷 이후 pid가 쓴 틱. 앞 스냅샷에 없던 프로세스는 전부 센다.
+int ticks_since(struct pstat *p)
+{
+  int i;
+
+  for (i = 0; i < nprev; i++)
+    if (prev[i].pid == p->pid)
+      return p->ticks - prev[i].ticks;
+  return p->ticks;
+}
+
+// interval 틱마다 count번, 그 사이에 많이 돈 프로세스부터 출력
+void top(int count, int interval)
+{
+  int n, i, j, k, tmp, delta[NPROC], order[NPROC];
+
+  nprev = procinfo(prev, NPROC);
+  while (count-- > 0)
+  {
+    sleep(interval);
+    if ((n = procinfo(ps, NPROC)) < 0)
+    {
+      printf(1, "procinfo failed\n");
+      return;
+    }
+    for (i = 0; i < n; i++)
+    {
+      delta[i] = ticks_since(&ps[i]);
+      order[i] = i;
+    }
+    for (i = 0; i < n; i++)
+      for (j = i + 1; j < n; j++)
+        if (delta[order[j]] > delta[order[i]])
+        {
+          tmp = order[i];
+          order[i] = order[j];
+          order[j] = tmp;
+        }
+    printf(1, "\n%d processes, %d ticks\n", n, interval);
+    printf(1, "PID\tSTATE\tTHR\tRSS\tCPU\tTICKS\tNAME\n");
+    for (i = 0; i < n; i++)
+    {
+      k = order[i];
+      printf(1, "%d\t%s\t%d\t%d\t%d%%\t%d\t%s\n",
+             ps[k].pid, statename(pstates, ps[k].state), ps[k].nthread,
+             ps[k].rss * 4096, delta[k] * 100 / interval, ps[k].ticks, ps[k].name);
+    }
+    memmove(prev, ps, n * sizeof(ps[0]));
+    nprev = n;
+  }
+}
+
 int main(void)
 {
   char input[1000];
@@ -63,7 +157,20 @@ int main(void)
 
     if (strcmp(args[0], "list") == 0)
     {
-      list_info();
+      int n = procinfo(ps, NPROC);
+      if (n < 0)
+        printf(1, "procinfo failed\n");
+      else
+        print_list(n, args[1] != 0 && strcmp(args[1], "-v") == 0);
+    }
+    else if (strcmp(args[0], "top") == 0)
+    {
+      // top [횟수] [간격(틱)]
+      int count = args[1] ? atoi(args[1]) : 10;
+      int interval = args[1] && args[2] ? atoi(args[2]) : 100;
+      if (interval < 1)
+        interval = 100;
+      top(count, interval);
     }
     else if (strcmp(args[0], "kill") == 0)
     {
@@ -111,6 +218,20 @@ int main(void)
         printf(1, "Memory limit set for process with PID %d\n", pid);
       }
     }
+    else if (strcmp(args[0], "memsoft") == 0)
+    {
+      int pid = atoi(args[1]);
+      int limit = atoi(args[2]);
+      int result = setmemorysoftlimit(pid, limit); // 넘으면 캐시된 쓰레드 스택을 회수하는 소프트 제한
+      if (result == -1)
+      {
+        printf(1, "Failed to set soft memory limit for process with PID %d\n", pid);
+      }
+      else
+      {
+        printf(1, "Soft memory limit set for process with PID %d\n", pid);
+      }
+    }
     else if (strcmp(args[0], "exit") == 0)
     {
       exit(); // pmanager 종료
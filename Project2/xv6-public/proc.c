@@ -6,11 +6,17 @@
 #include "x86.h"
 #include "proc.h"
 #include "spinlock.h"
+#include "traps.h"
+#include "pstat.h"
 
 static struct
 {
   struct spinlock lock;
   struct proc proc[NPROC];
+  // RUNNABLE 쓰레드들의 실행 큐 (FIFO). 스케줄러는 프로세스와 쓰레드
+  // 배열을 훑지 않고 맨 앞 쓰레드를 꺼내 바로 돌린다.
+  struct thread *qhead;
+  struct thread *qtail;
 } ptable;
 static struct proc *initproc;
 
@@ -19,6 +25,7 @@ extern void forkret(void);
 extern void trapret(void);
 
 static void wakeup1(void *chan);
+static void wakethreads(struct proc *p);
 
 void pinit(void)
 {
@@ -66,6 +73,321 @@ myproc(void)
   return p;
 }
 
+// Same as myproc(), for the thread running on this cpu.
+struct thread *
+mythread(void)
+{
+  struct cpu *c;
+  struct thread *t;
+  pushcli();
+  c = mycpu();
+  t = c->thr;
+  popcli();
+  return t;
+}
+
+// Make t RUNNABLE and append it to the run queue.
+// The ptable lock must be held.
+static void
+setrunnable(struct thread *t)
+{
+  t->thr_state = THR_RUNNABLE;
+  t->qnext = 0;
+  if (ptable.qtail)
+    ptable.qtail->qnext = t;
+  else
+    ptable.qhead = t;
+  ptable.qtail = t;
+}
+
+// Take the thread at the head of the run queue, or 0 if it is empty.
+// The ptable lock must be held.
+static struct thread *
+dequeue(void)
+{
+  struct thread *t;
+
+  if ((t = ptable.qhead) != 0)
+  {
+    ptable.qhead = t->qnext;
+    if (ptable.qhead == 0)
+      ptable.qtail = 0;
+    t->qnext = 0;
+  }
+  return t;
+}
+
+// Look in p's thread list for an UNUSED thread. If found, give it a
+// kernel stack set up to start at forkret, like allocproc() used to do
+// for a process, and make it EMBRYO. Otherwise return 0.
+// A slot keeps the stacks of the last thread that used it (see
+// freethread), so slots that still have a user stack are taken first
+// and their kernel stack is reused without kalloc.
+// The ptable lock must be held.
+static struct thread *
+allocthread(struct proc *p)
+{
+  struct thread *t, *free;
+  char *sp;
+
+  free = 0;
+  for (t = p->thrlist.thread; t < &p->thrlist.thread[NTHR]; t++)
+  {
+    if (t->thr_state != THR_UNUSED)
+      continue;
+    if (t->ustack)
+      goto found;
+    if (free == 0)
+      free = t;
+  }
+  if ((t = free) == 0)
+    return 0;
+
+found:
+  if (t->kstack == 0 && (t->kstack = kalloc()) == 0)
+    return 0;
+  t->thr_state = THR_EMBRYO;
+  t->proc = p;
+  // 슬롯 번호를 tid의 하위 비트에 넣어 tidthread()가 바로 찾게 한다.
+  t->tid = p->nexttid++ * NTHR + (t - p->thrlist.thread);
+  t->chan = 0;
+  t->retval = 0;
+  t->joiner = 0;
+  t->ticks = 0;
+  t->nsyscall = 0;
+  p->nthread++;
+
+  sp = t->kstack + KSTACKSIZE;
+
+  // Leave room for trap frame.
+  sp -= sizeof *t->tf;
+  t->tf = (struct trapframe *)sp;
+
+  // Set up new context to start executing at forkret,
+  // which returns to trapret.
+  sp -= 4;
+  *(uint *)sp = (uint)trapret;
+
+  sp -= sizeof *t->context;
+  t->context = (struct context *)sp;
+  memset(t->context, 0, sizeof *t->context);
+  t->context->eip = (uint)forkret;
+
+  return t;
+}
+
+// Make a thread that is EMBRYO or ZOMBIE UNUSED. Its kernel stack and
+// user stack stay in the slot for allocthread() to hand to the next
+// thread, so creating and joining threads in a loop neither allocates
+// nor grows the process; freestacks() gives them back.
+// The ptable lock must be held.
+static void
+freethread(struct thread *t)
+{
+  if (t->thr_state == THR_EMBRYO)
+    t->proc->nthread--;
+  // 끝난 쓰레드의 사용량은 프로세스에 남긴다.
+  t->proc->ticks += t->ticks;
+  t->proc->nsyscall += t->nsyscall;
+  t->ticks = 0;
+  t->nsyscall = 0;
+  t->context = 0;
+  t->tf = 0;
+  t->thr_state = THR_UNUSED;
+  t->tid = 0;
+  t->chan = 0;
+  t->retval = 0;
+  t->joiner = 0;
+}
+
+// Return the live thread of p with the given tid, or 0. A tid holds its
+// slot in the low bits (see allocthread), so there is nothing to scan.
+static struct thread *
+tidthread(struct proc *p, thread_t tid)
+{
+  struct thread *t = &p->thrlist.thread[tid % NTHR];
+
+  if (t->thr_state == THR_UNUSED || t->tid != tid)
+    return 0;
+  return t;
+}
+
+// Free the kernel stacks cached in p's UNUSED thread slots and forget
+// their user stacks, once the process or its address space is gone.
+// The ptable lock must be held.
+static void
+freestacks(struct proc *p)
+{
+  struct thread *t;
+
+  for (t = p->thrlist.thread; t < &p->thrlist.thread[NTHR]; t++)
+  {
+    if (t->thr_state != THR_UNUSED)
+      continue;
+    if (t->kstack)
+      kfree(t->kstack);
+    t->kstack = 0;
+    t->ustack = 0;
+    t->tls = 0;
+  }
+}
+
+// Pages of physical memory p holds: its address space, page tables
+// included, as counted in p->rss, and the kernel stacks of its
+// threads, cached ones too. p->rss follows every place that maps or
+// unmaps a user page; a copy-on-write split in cowfault() swaps one
+// mapping for another and leaves it alone. The ptable lock must be
+// held.
+static uint
+procpages(struct proc *p)
+{
+  struct thread *t;
+  uint n;
+
+  n = p->rss;
+  for (t = p->thrlist.thread; t < &p->thrlist.thread[NTHR]; t++)
+    if (t->kstack)
+      n += KSTACKSIZE / PGSIZE;
+  return n;
+}
+
+// Give back the stacks cached in p's UNUSED thread slots. Kernel stacks
+// are freed now; the pages of user stacks are unmapped, leaving a hole
+// in the address space, and pushed onto *freed for the caller to free
+// with freepages() once the lock is released. If freed is 0, because
+// the caller cannot release the lock, user stacks are kept.
+// The ptable lock must be held.
+static void
+reclaim(struct proc *p, char **freed)
+{
+  struct thread *t;
+
+  for (t = p->thrlist.thread; t < &p->thrlist.thread[NTHR]; t++)
+  {
+    if (t->thr_state != THR_UNUSED)
+      continue;
+    if (t->kstack)
+      kfree(t->kstack);
+    t->kstack = 0;
+    if (freed == 0)
+      continue;
+    if (t->ustack)
+      p->rss -= unmapuvm(p->pgdir, t->ustack + 2 * PGSIZE, t->ustack, freed);
+    t->ustack = 0;
+    t->tls = 0;
+  }
+}
+
+// Check that p may take npages more pages of physical memory. Past its
+// soft limit, or when the pages would not fit under its hard limit
+// otherwise, the cached stacks are reclaimed first. Returns 0 if the
+// pages fit under the hard limit, -1 if not.
+// The ptable lock must be held.
+static int
+memcharge(struct proc *p, uint npages, char **freed)
+{
+  uint n;
+
+  if (p->limit == 0 && p->softlimit == 0)
+    return 0;
+  n = (procpages(p) + npages) * PGSIZE;
+  if ((p->softlimit != 0 && n > (uint)p->softlimit) || (p->limit != 0 && n > (uint)p->limit))
+  {
+    reclaim(p, freed);
+    n = (procpages(p) + npages) * PGSIZE;
+  }
+  if (p->limit != 0 && n > (uint)p->limit)
+    return -1;
+  return 0;
+}
+
+// Free the pages unmapped from p and chained on freed, by unmapuvm()
+// or reclaim(). Other cpus running threads of p may still have them
+// in their TLBs, so those are flushed first.
+// Call with no locks held.
+static void
+freepages(struct proc *p, char *freed)
+{
+  char *v;
+
+  if (freed == 0)
+    return;
+  tlbshootdown(p);
+  while ((v = freed) != 0)
+  {
+    freed = *(char **)v;
+    kfree(v);
+  }
+}
+
+// Map a zeroed page for a fault at va on heap that sbrk made room for
+// but nothing has touched yet (see growproc), if the hard limit allows.
+// kernel is set for a fault in a system call using user memory, maybe
+// while it holds ptable.lock (thread_join stores *retval under it). Such
+// an access cannot fail, so going over the limit then kills the process
+// instead. Returns 0 if the page is mapped.
+int heapfault(uint va, int kernel)
+{
+  struct proc *p = myproc();
+  char *freed;
+  int locked, r;
+  uint n;
+
+  va = PGROUNDDOWN(va);
+  if ((locked = holding(&ptable.lock)) == 0)
+    acquire(&ptable.lock);
+  freed = 0;
+  r = -1;
+  if (va >= p->sz)
+    goto out;
+  // 다른 쓰레드가 먼저 매핑했을 수 있다.
+  if (uva2ka(p->pgdir, (char *)va) != 0)
+  {
+    r = 0;
+    goto out;
+  }
+  n = uvmgrowth(p->pgdir, va, va + PGSIZE);
+  if (memcharge(p, n, locked ? 0 : &freed) < 0)
+  {
+    if (!kernel)
+      goto out;
+    p->killed = 1;
+  }
+  if ((r = lazyfault(p->pgdir, p->sz, va)) > 0)
+  {
+    p->rss += n;
+    r = 0;
+  }
+out:
+  if (!locked)
+  {
+    release(&ptable.lock);
+    freepages(p, freed);
+  }
+  return r;
+}
+
+// Make the current thread a ZOMBIE and leave the cpu for good, while
+// the rest of its process goes on. thread_join() or, for threads that
+// were killed, wait() or exec() frees it later.
+// The ptable lock must be held.
+static void
+threadzombie(void)
+{
+  struct thread *t = mythread();
+
+  t->thr_state = THR_ZOMBIE;
+  t->proc->nthread--;
+  // thread_join으로 기다리는 쓰레드 하나만 깨운다.
+  if (t->joiner && t->joiner->thr_state == THR_SLEEPING && t->joiner->chan == t)
+    setrunnable(t->joiner);
+  // killothers()는 프로세스를 채널로 기다린다.
+  if (t->proc->killed)
+    wakeup1(t->proc);
+  sched();
+  panic("zombie thread exit");
+}
+
 // PAGEBREAK: 32
 //  Look in the process table for an UNUSED proc.
 //  If found, change state to EMBRYO and initialize
@@ -75,7 +397,6 @@ static struct proc *
 allocproc(void)
 {
   struct proc *p;
-  char *sp;
 
   acquire(&ptable.lock);
 
@@ -89,41 +410,24 @@ allocproc(void)
 found:
   // 프로세스 정보 초기화
   p->nexttid = 1;
+  p->nthread = 0;
   p->state = EMBRYO;
   p->pid = nextpid++;
   p->killed = 0;
   p->limit = 0;
-  // allocproc에서 0번 쓰레드를 메인 쓰레드로 하고, 정보 초기화
-  p->thrlist.thread[0].pid = p->pid;
-  p->thrlist.thread[0].thr_state = EMBRYO;
-  p->thrlist.thread[0].tid = p->nexttid++;
-
-  release(&ptable.lock);
-
-  // Allocate kernel stack.
-  if ((p->thrlist.thread[0].kstack = kalloc()) == 0) // 0번 쓰레드가 메인 쓰레드이므로 kstack할당 그 후 tf, context 넣어줌.
+  p->softlimit = 0;
+  p->rss = 0;
+  p->ticks = 0;
+  p->nsyscall = 0;
+  // 메인 쓰레드. 새 프로세스의 쓰레드 배열은 비어 있으므로 0번 자리를 받는다.
+  if (allocthread(p) == 0)
   {
     p->state = UNUSED;
-    p->thrlist.thread[0].thr_state = THR_UNUSED;
+    release(&ptable.lock);
     return 0;
   }
-  sp = p->thrlist.thread[0].kstack + KSTACKSIZE;
 
-  // Leave room for trap frame.
-  sp -= sizeof *p->thrlist.thread[0].tf;
-  p->thrlist.thread[0].tf = (struct trapframe *)sp;
-
-  // Set up new context to start executing at forkret,
-  // which returns to trapret.
-  sp -= 4;
-  *(uint *)sp = (uint)trapret;
-
-  sp -= sizeof *p->thrlist.thread[0].context;
-  p->thrlist.thread[0].context = (struct context *)sp;
-  memset(p->thrlist.thread[0].context, 0, sizeof *p->thrlist.thread[0].context);
-  p->thrlist.thread[0].context->eip = (uint)forkret;
-
-  p->curThrIdx = 0; // 현재 인덱스 0으로 설정
+  release(&ptable.lock);
 
   return p;
 }
@@ -143,6 +447,7 @@ void userinit(void)
     panic("userinit: out of memory?");
   inituvm(p->pgdir, _binary_initcode_start, (int)_binary_initcode_size);
   p->sz = PGSIZE;
+  p->rss = uvmpages(p->pgdir);
 
   // memset(p->tf, 0, sizeof(*p->tf));
   // p->tf->cs = (SEG_UCODE << 3) | DPL_USER;
@@ -175,51 +480,61 @@ void userinit(void)
   acquire(&ptable.lock);
   // runnable로 설정
   p->state = RUNNABLE;
-  p->curThrIdx = 0;
-  t->thr_state = THR_RUNNABLE;
+  setrunnable(t);
 
   release(&ptable.lock);
 }
 
 // Grow current process's memory by n bytes.
-// Return 0 on success, -1 on failure.
+// Return the old size on success, -1 on failure.
 int growproc(int n)
 {
-  uint sz;
+  uint sz, oldsz;
+  char *freed;
   struct proc *curproc = myproc();
-  sz = curproc->sz;
+  struct thread *t;
+
+  // 같은 프로세스의 다른 쓰레드들도 sbrk와 thread_create로 sz를 바꾸므로
+  // ptable.lock을 잡고 읽고 바꾼다.
+  acquire(&ptable.lock);
+  sz = oldsz = curproc->sz;
+  freed = 0;
   if (n > 0)
   {
-    if (curproc->limit == 0) // unlimied 상태
-    {
-      if ((sz = allocuvm(curproc->pgdir, sz, sz+n)) == 0)
-      {
-        return -1;
-      }
-    }
-    else if (curproc->limit != 0)
-    {
-      if (curproc->limit >= sz + n) // 할당해도 되는지 검사
-      {
-        if ((sz = allocuvm(curproc->pgdir, sz, sz + n)) == 0)
-        {
-          return -1;
-        }
-      }
-      else
-      {
-        return -1;
-      }
-    }
+    if (sz + n < sz || sz + n >= KERNBASE)
+      goto bad;
+    // 페이지는 처음 건드릴 때 할당하고 그때 메모리 제한을 검사한다 (heapfault).
+    // 여기서는 지금 상주한 페이지에 새로 늘어난 영역만 다 더해 보고, 그것도
+    // 들어가지 않으면 바로 실패시킨다. 기존 영역에서 아직 건드리지 않은
+    // 페이지(스택 회수로 생긴 구멍 포함)는 세지 않으므로, 통과해도 나중에
+    // 건드릴 때 제한에 걸릴 수 있다.
+    if (memcharge(curproc, uvmgrowth(curproc->pgdir, sz, sz + n), &freed) < 0)
+      goto bad;
+    sz += n;
   }
   else if (n < 0)
   {
-    if ((sz = deallocuvm(curproc->pgdir, sz, sz + n)) == 0)
-      return -1;
+    if ((uint)-n > sz)
+      goto bad;
+    curproc->rss -= unmapuvm(curproc->pgdir, sz, sz + n, &freed);
+    sz += n;
+    // 줄어든 영역에 있던 스택 풀의 유저 스택은 버린다.
+    for (t = curproc->thrlist.thread; t < &curproc->thrlist.thread[NTHR]; t++)
+      if (t->thr_state == THR_UNUSED && t->ustack + 2 * PGSIZE > sz)
+        t->ustack = 0;
   }
   curproc->sz = sz;
-  switchuvm(curproc);
-  return 0;
+  release(&ptable.lock);
+  switchuvm(mythread());
+  // 다른 cpu에서 도는 쓰레드들의 TLB에 줄어든 페이지가 남아 있을 수
+  // 있으므로, 모두 비운 뒤에 페이지를 돌려준다.
+  freepages(curproc, freed);
+  return oldsz;
+
+bad:
+  release(&ptable.lock);
+  freepages(curproc, freed);
+  return -1;
 }
 
 // Create a new process copying p as the parent.
@@ -228,6 +543,7 @@ int growproc(int n)
 int fork(void)
 {
   int i, pid;
+  uint sz;
   struct proc *np;
   struct proc *curproc = myproc();
   // Allocate process.
@@ -236,23 +552,32 @@ int fork(void)
     return -1;
   }
 
-  // 현재 프로세스의 페이지 테이블을 복사.
-  if ((np->pgdir = copyuvm(curproc->pgdir, curproc->sz)) == 0)
+  // 현재 프로세스의 페이지 테이블을 복사. 다른 쓰레드가 sbrk로 sz를 바꿀 수
+  // 있으므로 growproc처럼 ptable.lock을 잡고 읽는다. 그 사이 줄어든 부분은
+  // 매핑이 없으니 건너뛰고, 자식에서는 건드릴 때 다시 할당된다.
+  acquire(&ptable.lock);
+  sz = curproc->sz;
+  release(&ptable.lock);
+  if ((np->pgdir = copyuvm(curproc->pgdir, sz)) == 0)
   {
-    kfree(np->thrlist.thread[0].kstack);
-    np->thrlist.thread[0].kstack = 0;
-    np->thrlist.thread[0].thr_state = UNUSED;
+    acquire(&ptable.lock);
+    freethread(&np->thrlist.thread[0]);
+    freestacks(np);
     np->state = UNUSED;
+    release(&ptable.lock);
     return -1;
   }
-  // sz, parent, curThrIdx 정보 초기화
-  np->sz = curproc->sz;
+  // 부모의 페이지들은 이제 copy-on-write로 읽기 전용이다. 다른 cpu에서
+  // 도는 부모 쓰레드들의 TLB에도 쓰기 가능한 항목이 남지 않게 한다.
+  lcr3(V2P(curproc->pgdir));
+  tlbshootdown(curproc);
+  // sz, parent 정보 초기화
+  np->sz = sz;
+  np->rss = uvmpages(np->pgdir);
   np->parent = curproc;
-  np->curThrIdx = 0;
 
-  // Swap stacks of current thread index and index 0.
-  // tf정보도 복사
-  *np->thrlist.thread[0].tf = *curproc->tf;
+  // fork를 부른 쓰레드의 tf를 자식의 메인 쓰레드로 복사
+  *np->thrlist.thread[0].tf = *mythread()->tf;
 
   // Clear %eax so that fork returns 0 in the child.
   np->thrlist.thread[0].tf->eax = 0;
@@ -268,23 +593,45 @@ int fork(void)
 
   acquire(&ptable.lock);
 
+  // 자식의 주소 공간에도 부모 쓰레드들의 유저 스택이 있으므로 자식의 스택
+  // 풀로 넘겨준다. fork를 부른 쓰레드의 스택은 자식의 메인 쓰레드가 쓴다.
+  for (i = 1; i < NTHR; i++)
+    if (&curproc->thrlist.thread[i] != mythread())
+      np->thrlist.thread[i].ustack = curproc->thrlist.thread[i].ustack;
+  np->thrlist.thread[0].ustack = mythread()->ustack;
+  // TLS도 fork를 부른 쓰레드의 것을 그대로 쓰되, tid만 자식 메인 쓰레드의 것으로 바꾼다.
+  np->thrlist.thread[0].tls = mythread()->tls;
+  if (mythread()->tls)
+    copyout(np->pgdir, mythread()->tls + 4, &np->thrlist.thread[0].tid, 4);
+
   np->state = RUNNABLE;
-  np->thrlist.thread[0].thr_state = THR_RUNNABLE;
+  setrunnable(&np->thrlist.thread[0]);
   release(&ptable.lock);
   return pid;
 }
 // Exit the current process.  Does not return.
 // An exited process remains in the zombie state
 // until its parent calls wait() to find out it exited.
+// Any thread may call it. The other threads of the process are killed,
+// and the last thread to get here tears the process down.
 void exit(void)
 {
   struct proc *curproc = myproc();
   struct proc *p;
-  struct thread *t;
   int fd;
   if (curproc == initproc)
     panic("init exiting");
 
+  acquire(&ptable.lock);
+  // 다른 쓰레드들도 kill과 같은 방법으로 끝내게 한다.
+  // exec이 정리 중(EXECKILL)이라면 이 쓰레드만 끝난다.
+  if (!curproc->killed)
+    curproc->killed = 1;
+  wakethreads(curproc);
+  if (curproc->nthread > 1)
+    threadzombie();
+  release(&ptable.lock);
+
   // Close all open files.
   for (fd = 0; fd < NOFILE; fd++)
   {
@@ -315,16 +662,10 @@ void exit(void)
         wakeup1(initproc);
     }
   }
-  // 현재 프로세스의 상태를 좀비로 바꾸고
+  // 마지막 쓰레드이므로 프로세스와 함께 좀비가 된다.
   curproc->state = ZOMBIE;
-  // 쓰레드의 상태를 unused가 아니면 좀비로 바꿔준다.
-  for (t = curproc->thrlist.thread; t < &curproc->thrlist.thread[NTHR]; t++)
-  {
-    if (t->thr_state != THR_UNUSED)
-    {
-      t->thr_state = THR_ZOMBIE;
-    }
-  }
+  mythread()->thr_state = THR_ZOMBIE;
+  curproc->nthread--;
   sched();
   panic("zombie exit");
 }
@@ -337,7 +678,6 @@ int wait(void)
   int havekids, pid;
   struct proc *curproc = myproc();
   struct thread *t;
-  uint idx = 0;
   acquire(&ptable.lock);
   for (;;)
   {
@@ -353,23 +693,15 @@ int wait(void)
         // Found one.
         pid = p->pid;
         // 쓰레드 배열을 돌면서 프로세스의 쓰레드들의 자원을 회수해주고 정리해준다.
-        for (idx = 0, t = p->thrlist.thread; t < &p->thrlist.thread[NTHR]; idx++, t++)
+        for (t = p->thrlist.thread; t < &p->thrlist.thread[NTHR]; t++)
         {
           if (t->thr_state != THR_UNUSED)
-          {
-            kfree(t->kstack);
-          }
-          t->kstack = 0;
-          t->context = 0;
-          t->thr_state = THR_UNUSED;
-          t->tid = 0;
-          t->chan = 0;
-          t->retval = 0;
-          t->tf = 0;
+            freethread(t);
         }
+        freestacks(p);
         // 프로세스의 정보도 회수&정리
-        p->kstack = 0;
         freevm(p->pgdir);
+        p->rss = 0;
         p->pid = 0;
         p->parent = 0;
         p->name[0] = 0;
@@ -393,93 +725,49 @@ int wait(void)
 }
 
 // PAGEBREAK: 42
-//  Per-CPU process scheduler.
+//  Per-CPU thread scheduler.
 //  Each CPU calls scheduler() after setting itself up.
 //  Scheduler never returns.  It loops, doing:
-//   - choose a process to run
-//   - swtch to start running that process
-//   - eventually that process transfers control
+//   - take the thread at the head of the run queue
+//   - swtch to start running that thread
+//   - eventually that thread transfers control
 //       via swtch back to the scheduler.
+//  Threads of one process can run on several CPUs at once.
 void scheduler(void)
 {
-
-  struct proc *p;
   struct cpu *c = mycpu();
   struct thread *t;
-  uint idx = 0;
   c->proc = 0;
+  c->thr = 0;
 
   for (;;)
   {
     // Enable interrupts on this processor.
     sti();
 
-    // Loop over process table looking for process to run.
     acquire(&ptable.lock);
-    for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+    if ((t = dequeue()) != 0)
     {
-      if (p->state != RUNNABLE)
-        continue;
-      for (idx = 0, t = p->thrlist.thread; t < &p->thrlist.thread[NTHR]; idx++, t++)
-      {
-        if (t->thr_state != THR_RUNNABLE)
-        {
-          continue;
-        }
-        // 프로세스에 쓰레드의 정보를 넣어주는 과정
-        p->curThrIdx = idx;
-        p->kstack = t->kstack;
-        p->context = t->context;
-        p->tf = t->tf;
-        c->proc = p;
-        switchuvm(p);
-        p->state = RUNNING;
-        swtch(&(c->scheduler), p->context);
-        switchkvm();
-        // 스케줄러 후
-        if (p->state != ZOMBIE) // kill되지 않았다면..
-        {
-          if (t->execVisited == 1) // exec을 갔다온 뒤라면
-          {
-            p->curThrIdx = 0; // curThrIdx를 0으로 바꿔주고, 메인 쓰레드에 kstack, context, tf 대입.
-            p->thrlist.thread[0].kstack = p->kstack;
-            p->thrlist.thread[0].context = p->context;
-            p->thrlist.thread[0].tf = p->tf;
-            // 원래 쓰레드의 자원 정리. kfree는 하면 안됨. 포인터만 0으로 바꿔준다.
-            t->execVisited = 0;
-            t->kstack = 0;
-            t->chan = 0;
-            t->thr_state = THR_UNUSED;
-            t->retval = 0;
-            t->tid = 0;
-            t->pid = 0;
-            t->context = 0;
-            t->tf = 0;
-          }
-          else
-          {
-            // 프로세스의 상태를 쓰레드에 대입한다.
-            t->kstack = p->kstack;
-            t->context = p->context;
-            t->tf = p->tf;
-          }
-        }
-        else // kill되었다면 종료.
-        {
-          break;
-        }
-        // Process is done running for now.
-        // It should have changed its p->state before coming back.
-
-        c->proc = 0;
-      }
+      // 쓰레드가 kstack, context, tf를 직접 가지고 있으므로
+      // 프로세스로 복사할 것 없이 바로 전환한다.
+      c->proc = t->proc;
+      c->thr = t;
+      switchuvm(t);
+      t->thr_state = THR_RUNNING;
+      swtch(&(c->scheduler), t->context);
+      switchkvm();
+
+      // Thread is done running for now.
+      // It should have changed its thr_state before coming back.
+      c->proc = 0;
+      c->thr = 0;
     }
     release(&ptable.lock);
   }
 }
 
 // Enter scheduler.  Must hold only ptable.lock
-// and have changed proc->state. Saves and restores
+// and have changed thr_state of the current thread. Saves and restores
 // intena because intena is a property of this
 // kernel thread, not this CPU. It should
 // be proc->intena and proc->ncli, but that would
@@ -488,18 +776,18 @@ void scheduler(void)
 void sched(void)
 {
   int intena;
-  struct proc *p = myproc();
+  struct thread *t = mythread();
 
   if (!holding(&ptable.lock))
     panic("sched ptable.lock");
   if (mycpu()->ncli != 1)
     panic("sched locks");
-  if (p->state == RUNNING)
+  if (t->thr_state == THR_RUNNING)
     panic("sched running");
   if (readeflags() & FL_IF)
     panic("sched interruptible");
   intena = mycpu()->intena;
-  swtch(&p->context, mycpu()->scheduler);
+  swtch(&t->context, mycpu()->scheduler);
   mycpu()->intena = intena;
 }
 
@@ -507,7 +795,7 @@ void sched(void)
 void yield(void)
 {
   acquire(&ptable.lock); // DOC: yieldlock
-  myproc()->state = RUNNABLE;
+  setrunnable(mythread());
   sched();
   release(&ptable.lock);
 }
@@ -537,9 +825,8 @@ void forkret(void)
 // Reacquires lock when awakened.
 void sleep(void *chan, struct spinlock *lk)
 {
-  struct proc *p = myproc();
-  struct thread *t = &p->thrlist.thread[p->curThrIdx];
-  if (p == 0)
+  struct thread *t = mythread();
+  if (t == 0)
     panic("sleep");
 
   if (lk == 0)
@@ -554,7 +841,6 @@ void sleep(void *chan, struct spinlock *lk)
   // chan을 대입해주고, 쓰레드만 자게 한다.
   t->chan = chan;
   t->thr_state = THR_SLEEPING;
-  p->state = RUNNABLE;
   sched();
 
   // Tidy up.
@@ -569,7 +855,7 @@ void sleep(void *chan, struct spinlock *lk)
 }
 
 // PAGEBREAK!
-//  Wake up all processes sleeping on chan.
+//  Wake up all threads sleeping on chan.
 //  The ptable lock must be held.
 static void
 wakeup1(void *chan)
@@ -579,16 +865,30 @@ wakeup1(void *chan)
 
   for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
   {
+    if (p->state == UNUSED)
+      continue;
     for (t = p->thrlist.thread; t < &p->thrlist.thread[NTHR]; t++)
     {
       if (t->thr_state == THR_SLEEPING && t->chan == chan)
-      { // 쓰레드가 자고 있고, chan정보가 맞다면, thr_state는 runnable로 바꿔준다.
-        t->thr_state = THR_RUNNABLE;
+      { // 쓰레드가 자고 있고, chan정보가 맞다면, 실행 큐에 넣어준다.
+        setrunnable(t);
       }
     }
   }
 }
 
+// Wake every sleeping thread of p, so that each notices p->killed.
+// The ptable lock must be held.
+static void
+wakethreads(struct proc *p)
+{
+  struct thread *t;
+
+  for (t = p->thrlist.thread; t < &p->thrlist.thread[NTHR]; t++)
+    if (t->thr_state == THR_SLEEPING)
+      setrunnable(t);
+}
+
 // Wake up all processes sleeping on chan.
 void wakeup(void *chan)
 {
@@ -603,7 +903,6 @@ void wakeup(void *chan)
 int kill(int pid)
 {
   struct proc *p;
-  struct thread *t;
 
   acquire(&ptable.lock);
   for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
@@ -611,13 +910,8 @@ int kill(int pid)
     if (p->pid == pid)
     {
       p->killed = 1;
-      for (t = p->thrlist.thread; t < &p->thrlist.thread[NTHR]; t++)
-      {
-        // 사용되지 않은 쓰레드가 아니라면 모두 runnable로 바꿔준다.
-        if (t->thr_state == THR_UNUSED)
-          continue;
-        t->thr_state = THR_RUNNABLE;
-      }
+      // 자고 있는 쓰레드들을 깨워 killed를 보게 한다.
+      wakethreads(p);
       release(&ptable.lock);
       return 0;
     }
@@ -626,6 +920,105 @@ int kill(int pid)
   return -1;
 }
 
+// Leave the current thread as the only one in its process, for exec().
+// The other threads are killed and waited for, and then freed, so that
+// nothing runs on the old address space any more.
+// Returns -1 without doing anything if the process is being killed
+// already, by kill(), exit() or an exec() in another thread, which
+// would be waiting for this thread to go away; it does on its way back
+// to user space.
+int killothers(void)
+{
+  struct proc *p = myproc();
+  struct thread *t;
+
+  acquire(&ptable.lock);
+  if (p->killed)
+  {
+    release(&ptable.lock);
+    return -1;
+  }
+  if (p->nthread > 1)
+  {
+    p->killed = EXECKILL;
+    wakethreads(p);
+    while (p->nthread > 1)
+      sleep(p, &ptable.lock);
+    if (p->killed == EXECKILL)
+      p->killed = 0;
+  }
+  for (t = p->thrlist.thread; t < &p->thrlist.thread[NTHR]; t++)
+  {
+    if (t->thr_state == THR_ZOMBIE)
+      freethread(t);
+    // 옛 주소 공간과 함께 유저 스택들도 사라진다. 커널 스택은 남겨 재사용한다.
+    t->ustack = 0;
+  }
+  release(&ptable.lock);
+  return 0;
+}
+
+// Flush this cpu's TLB if another cpu asked for it. Called from the
+// T_TLBFLUSH interrupt, and polled by loops that spin with interrupts
+// disabled (acquire, shootdown) so that a cpu waiting for this one
+// cannot deadlock with it. Interrupts must be disabled.
+void tlbpoll(void)
+{
+  struct cpu *c;
+
+  c = mycpu();
+  if (xchg(&c->tlbflushreq, 0))
+  {
+    lcr3(rcr3());
+    c->tlbflushes++;
+  }
+}
+
+// Make every other cpu running a thread of p flush its TLB, and wait
+// until each has, so that pages just unmapped from p can be reused.
+// A cpu that is not running p has flushed p's entries on its way out
+// (switchkvm reloads %cr3), and one that starts running p later loads
+// the page table as it is now. A cpu that has interrupts disabled
+// still answers from tlbpoll() if it spins on a lock, maybe one the
+// caller holds, or is shooting down this cpu at the same time; any
+// other stretch with interrupts off ends soon. So this may be called
+// with spinlocks held and from a page fault in the kernel.
+void tlbshootdown(struct proc *p)
+{
+  struct cpu *c, *me;
+  uint seen[NCPU];
+  int sent[NCPU];
+  int i;
+
+  pushcli();
+  me = mycpu();
+  for (i = 0; i < ncpu; i++)
+  {
+    c = &cpus[i];
+    sent[i] = c != me && c->proc == p;
+    if (sent[i])
+    {
+      seen[i] = c->tlbflushes;
+      c->tlbflushreq = 1;
+      lapicipi(c->apicid, T_TLBFLUSH);
+    }
+  }
+  for (i = 0; i < ncpu; i++)
+    while (sent[i] && cpus[i].tlbflushes == seen[i])
+      tlbpoll();
+  popcli();
+}
+
+// After cowfault() moved a page of p to a copy of its own, make the
+// other cpus running threads of p drop the entry for the shared page
+// before the faulting write goes ahead. Until then they could read the
+// old frame, which the other sharers may by now write or free.
+void cowflush(struct proc *p)
+{
+  if (p->nthread > 1)
+    tlbshootdown(p);
+}
+
 // PAGEBREAK: 36
 //  Print a process listing to console.  For debugging.
 //  Runs when user types ^P on console.
@@ -633,14 +1026,15 @@ int kill(int pid)
 void procdump(void)
 {
   static char *states[] = {
-      [UNUSED] "unused",
-      [EMBRYO] "embryo",
-      [SLEEPING] "sleep ",
-      [RUNNABLE] "runble",
-      [RUNNING] "run   ",
-      [ZOMBIE] "zombie"};
+      [THR_UNUSED] "unused",
+      [THR_EMBRYO] "embryo",
+      [THR_SLEEPING] "sleep ",
+      [THR_RUNNABLE] "runble",
+      [THR_RUNNING] "run   ",
+      [THR_ZOMBIE] "zombie"};
   int i;
   struct proc *p;
+  struct thread *t;
   char *state;
   uint pc[10];
 
@@ -648,226 +1042,335 @@ void procdump(void)
   {
     if (p->state == UNUSED)
       continue;
-    if (p->state >= 0 && p->state < NELEM(states) && states[p->state])
-      state = states[p->state];
-    else
-      state = "???";
-    cprintf("%d %s %s", p->pid, state, p->name);
-    if (p->state == SLEEPING)
+    cprintf("%d %s%s\n", p->pid, p->name, p->state == ZOMBIE ? " zombie" : "");
+    for (t = p->thrlist.thread; t < &p->thrlist.thread[NTHR]; t++)
     {
-      getcallerpcs((uint *)p->context->ebp + 2, pc);
-      for (i = 0; i < 10 && pc[i] != 0; i++)
-        cprintf(" %p", pc[i]);
+      if (t->thr_state == THR_UNUSED)
+        continue;
+      if (t->thr_state >= 0 && t->thr_state < NELEM(states) && states[t->thr_state])
+        state = states[t->thr_state];
+      else
+        state = "???";
+      cprintf("  tid %d %s", t->tid, state);
+      if (t->thr_state == THR_SLEEPING)
+      {
+        getcallerpcs((uint *)t->context->ebp + 2, pc);
+        for (i = 0; i < 10 && pc[i] != 0; i++)
+          cprintf(" %p", pc[i]);
+      }
+      cprintf("\n");
     }
-    cprintf("\n");
   }
 }
 
-int setmemorylimit(int pid, int limit)
+static int
+setlimit(int pid, int limit, int soft)
 {
   struct proc *p;
+  char *freed;
+  int old, r;
+
   // limit이 0보다 작다면 out
   if (limit < 0)
-    goto bad;
+    return -1;
 
+  freed = 0;
+  acquire(&ptable.lock);
   for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
   {
-    // ptable을 돌면서 pid를 만나고, limit이 p->sz보다 작다면 p->limit을 limit으로 정해준다.
-    if (p->pid == pid)
-    {
-      if (p->sz > limit)
-      {
-        goto bad;
-      }
-      else
-      {
-        p->limit = limit;
-        return 0;
-      }
-    }
+    if (p->pid != pid || p->state == UNUSED)
+      continue;
+    old = p->limit;
+    if (soft)
+      p->softlimit = limit;
+    else
+      p->limit = limit;
+    // 캐시된 스택을 회수하고도 이미 하드 제한을 넘는다면 제한을 되돌린다.
+    if ((r = memcharge(p, 0, &freed)) < 0)
+      p->limit = old;
+    release(&ptable.lock);
+    freepages(p, freed);
+    return r;
   }
-  goto bad;
-bad:
+  release(&ptable.lock);
   return -1;
 }
 
+// Set the hard limit on the resident memory of process pid, in bytes;
+// 0 removes it. Fails if the process holds more than that already,
+// after giving back what it has cached.
+int setmemorylimit(int pid, int limit)
+{
+  return setlimit(pid, limit, 0);
+}
+
+// Set the soft limit of process pid, in bytes; 0 removes it. Past it,
+// the stacks cached in the process's thread slots are given back.
+int setmemorysoftlimit(int pid, int limit)
+{
+  return setlimit(pid, limit, 1);
+}
+
 void list_info() // ptable의 process중 unused되지 않은 프로세스의 정보를 출력
 {
   struct proc *p;
+  uint rss;
+
+  acquire(&ptable.lock);
   for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
   {
     if (p->state != UNUSED)
     {
+      rss = procpages(p);
       cprintf("name : %s\n", p->name);
       cprintf("pid is %d\n", p->pid);
       cprintf("stack page is %d\n", p->sz / 4096);
       cprintf("Memory size is %d\n", p->sz);
+      cprintf("Resident memory is %d (%d pages)\n", rss * PGSIZE, rss);
       cprintf("Memory limit is %d\n", p->limit);
+      cprintf("Soft memory limit is %d\n", p->softlimit);
       cprintf("\n");
     }
   }
+  release(&ptable.lock);
 }
 
-int thread_create(thread_t *thread, void *(*start_routine)(void *), void *arg)
-{ // 반환형이 void* 인자도 void*
+// Copy a snapshot of up to n processes in use, with their threads, to
+// the user array buf, which the caller has checked, and return how many
+// were copied. The whole table is read under the ptable lock, so the
+// snapshot is consistent; pages of buf that are not mapped yet fault in
+// meanwhile (see heapfault).
+int procinfo(struct pstat *buf, int n)
+{
+  // struct pstat is too large for the kernel stack; ptable.lock guards it.
+  static struct pstat ps;
   struct proc *p;
   struct thread *t;
-  uint sz;
-  char *sp;
-  int idx = 0;
+  struct tstat *ts;
+  int k;
 
+  k = 0;
   acquire(&ptable.lock);
-  p = myproc();
-  // 사용되지 않은 쓰레드를 찾았으면 넘어간다.
-  for (idx = 0, t = p->thrlist.thread; t < &p->thrlist.thread[NTHR]; idx++, t++)
-    if (t->thr_state == THR_UNUSED)
-      goto found;
-
-  release(&ptable.lock);
-  return -1;
-
-found:
-  // allocproc의 과정처럼 정보를 넣어준다. kstack할당, tf 대입, context 대입
-  t->thr_state = EMBRYO;
-  t->tid = *thread;
-
-  release(&ptable.lock);
-
-  // Allocate kernel stack.
-  if ((t->kstack = kalloc()) == 0)
+  for (p = ptable.proc; p < &ptable.proc[NPROC] && k < n; p++)
   {
-    t->thr_state = UNUSED;
-    goto bad;
+    if (p->state == UNUSED)
+      continue;
+    memset(&ps, 0, sizeof(ps));
+    ps.pid = p->pid;
+    ps.ppid = p->parent ? p->parent->pid : 0;
+    ps.state = p->state;
+    ps.killed = p->killed;
+    safestrcpy(ps.name, p->name, sizeof(ps.name));
+    ps.sz = p->sz;
+    ps.rss = procpages(p);
+    ps.limit = p->limit;
+    ps.softlimit = p->softlimit;
+    ps.ticks = p->ticks;
+    ps.nsyscall = p->nsyscall;
+    for (t = p->thrlist.thread; t < &p->thrlist.thread[NTHR]; t++)
+    {
+      if (t->thr_state == THR_UNUSED)
+        continue;
+      ts = &ps.thread[ps.nthread++];
+      ts->tid = t->tid;
+      ts->state = t->thr_state;
+      ts->ticks = t->ticks;
+      ts->nsyscall = t->nsyscall;
+      ps.ticks += t->ticks;
+      ps.nsyscall += t->nsyscall;
+    }
+    memmove(&buf[k], &ps, sizeof(ps));
+    k++;
   }
-  sp = t->kstack + KSTACKSIZE;
-
-  // Leave room for trap frame.
-  sp -= sizeof *t->tf;
-  t->tf = (struct trapframe *)sp;
-
-  // Set up new context to start executing at forkret,
-  // which returns to trapret.
-  sp -= 4;
-  *(uint *)sp = (uint)trapret;
+  release(&ptable.lock);
+  return k;
+}
 
-  sp -= sizeof *t->context;
-  t->context = (struct context *)sp;
-  memset(t->context, 0, sizeof *t->context);
-  t->context->eip = (uint)forkret;
-  // t->tf에 프로세스의 현재 쓰레드 trapframe을 대입.
-  *t->tf = *p->thrlist.thread[p->curThrIdx].tf;
-  // 그 후 유저스택에 인자를 넣어줌.
+int thread_create(thread_t *thread, void *(*start_routine)(void *), void *arg)
+{ // 반환형이 void* 인자도 void*
+  struct proc *p = myproc();
+  struct thread *t;
+  uint sz, n;
   uint ustacks[2];
   uint stackpointer = 0;
-  pde_t *pagedir = p->pgdir;
-  sz = PGROUNDUP(p->sz);
-  if (p->limit == 0) // unlimied 상태
-  {
-    if ((sz = allocuvm(pagedir, sz, sz + 2 * PGSIZE)) == 0)
-    {
-      goto bad;
-    }
-  }
-  else if (p->limit != 0)
+  char *freed;
+
+  // 같은 프로세스의 쓰레드들이 동시에 돌 수 있으므로, 쓰레드 배열과
+  // p->sz는 ptable.lock을 잡은 채로 바꾼다.
+  acquire(&ptable.lock);
+  // allocproc의 과정처럼 정보를 넣어준다. kstack할당, tf 대입, context 대입
+  if ((t = allocthread(p)) == 0)
   {
-    if (p->limit >= sz + 2 * PGSIZE) // 할당해도 되는지 검사
-    {
-      if ((sz = allocuvm(pagedir, sz, sz + 2 * PGSIZE)) == 0)
-      {
-        goto bad;
-      }
-    }
-    else
-    {
-      goto bad;
-    }
+    release(&ptable.lock);
+    return -1;
   }
-  clearpteu(pagedir, (char *)(sz - 2 * PGSIZE));
+  // t->tf에 지금 쓰레드의 trapframe을 대입.
+  *t->tf = *mythread()->tf;
+  freed = 0;
+  // 새 커널 스택은 이미 셌고, 유저 스택이 없으면 새로 만들 페이지도 센다.
+  sz = PGROUNDUP(p->sz);
+  n = t->ustack ? 0 : uvmgrowth(p->pgdir, sz, sz + 2 * PGSIZE);
+  if (memcharge(p, n, &freed) < 0)
+    goto bad;
+  // 슬롯에 전에 쓰던 유저 스택이 남아 있으면 그대로 쓰고, 없을 때만
+  // 가드 페이지와 스택 페이지를 새로 할당한다.
+  if (t->ustack)
+    goto havestack;
+  if ((sz = allocuvm(p->pgdir, sz, sz + 2 * PGSIZE)) == 0)
+    goto bad;
+  clearpteu(p->pgdir, (char *)(sz - 2 * PGSIZE));
   p->sz = sz;
-  stackpointer = sz;
+  p->rss += n;
+  t->ustack = sz - 2 * PGSIZE;
+
+havestack:
+  // 스택 페이지 맨 위에 TLS 블록을 두고, 그 아래에 인자를 넣어줌.
+  t->tls = t->ustack + 2 * PGSIZE - TLSSIZE;
+  if (tlsinit(p->pgdir, t->tls, t->tid) < 0)
+    goto bad;
+  t->tf->gs = (SEG_UTLS << 3) | DPL_USER;
+  stackpointer = t->tls;
   ustacks[0] = 0xffffffff; // fake return PC
   ustacks[1] = (uint)arg;
   stackpointer -= 8;
   // 그 후 pagedir에 ustack 복사.
-  if (copyout(pagedir, stackpointer, ustacks, 2 * 4) < 0)
+  if (copyout(p->pgdir, stackpointer, ustacks, 2 * 4) < 0)
     goto bad;
   // eip에 start_routine을 넣어주고, esp에 sp를 넣어준다.
   t->tf->eip = (uint)start_routine;
   t->tf->esp = stackpointer;
-  // 쓰레드의 상태를 runnable로 바꿔준다.
-  t->thr_state = THR_RUNNABLE;
-  p->pgdir = pagedir;
-  switchuvm(p);
+  // 만든 쓰레드의 tid를 돌려주고, 실행 큐에 넣는다.
+  *thread = t->tid;
+  setrunnable(t);
+  release(&ptable.lock);
+  freepages(p, freed);
   return 0;
 
 bad:
   // bad라면 정보 초기화
-  t->kstack = 0;
-  t->tid = 0;
-  t->thr_state = THR_UNUSED;
-
+  freethread(t);
   release(&ptable.lock);
+  freepages(p, freed);
   return -1;
 }
 
 void thread_exit(void *retval)
 {
   struct proc *p = myproc();
+
   acquire(&ptable.lock);
-  struct thread *t = &p->thrlist.thread[p->curThrIdx];
+  // 마지막 쓰레드라면 프로세스가 끝난다.
+  if (p->nthread == 1)
+  {
+    release(&ptable.lock);
+    exit();
+  }
   // 쓰레드의 상태를 zombie로 바꿔주고, retval을 대입해준다.
-  p->thrlist.thread[0].thr_state = THR_RUNNABLE;
-  t->thr_state = THR_ZOMBIE;
-  t->retval = retval;
-  p->state = RUNNABLE;
-  sched();
+  mythread()->retval = retval;
+  threadzombie();
 }
 
 int thread_join(thread_t thread, void **retval)
 {
   struct proc *p = myproc();
   struct thread *t;
-  uint idx = 0;
 
   acquire(&ptable.lock);
-  for (idx = 0, t = p->thrlist.thread; t < &p->thrlist.thread[NTHR]; idx++, ++t)
-  { // tid가 thread가 맞다면,
-    if (t->tid == thread)
-    {
-      if (t->thr_state != THR_UNUSED)
-      {
-        goto found;
-      }
-    }
+  // 없는 쓰레드, 자기 자신, 다른 쓰레드가 이미 기다리는 쓰레드는 join할 수 없다.
+  if ((t = tidthread(p, thread)) == 0 || t == mythread() ||
+      (t->joiner != 0 && t->joiner != mythread()))
+  {
+    release(&ptable.lock);
+    return -1;
   }
-  release(&ptable.lock);
+  t->joiner = mythread();
 
-  return -1;
-found:
   for (;;)
   { // zombie라면
     if (t->thr_state == THR_ZOMBIE)
     { // retval 저장
       *retval = t->retval;
-      if (t->kstack != 0)
-      {
-        kfree(t->kstack);
-      }
-      t->thr_state = THR_UNUSED;
-      t->context = 0;
-      t->tf = 0;
-      t->kstack = 0;
-      // t->retval = 0;
+      freethread(t);
       release(&ptable.lock);
       return 0;
     }
 
     if (p->killed) // 죽었다면 끝내기
     {
+      t->joiner = 0;
       release(&ptable.lock);
       return -1;
     }
 
-    sleep(&p->thrlist.thread[0], &ptable.lock);
+    // 쓰레드마다 따로 기다린다. threadzombie()가 이 쓰레드만 깨운다.
+    sleep(t, &ptable.lock);
   }
 }
+
+// A futex is keyed on the word's user address: only threads of the
+// process share it (futex_wake), and user addresses are below KERNBASE,
+// so the key never equals a channel the kernel itself sleeps on. The
+// physical page would not do, since a copy-on-write fault can move the
+// word to a new one while a thread sleeps on it.
+// Returns the kernel address of the word, or 0 if addr is not a
+// word-aligned user address of p.
+static int *
+futexword(struct proc *p, int *addr)
+{
+  char *page;
+
+  if ((uint)addr % sizeof *addr != 0)
+    return 0;
+  if ((page = uva2ka(p->pgdir, (char *)addr)) == 0)
+    return 0;
+  return (int *)(page + ((uint)addr & (PGSIZE - 1)));
+}
+
+// Sleep until futex_wake on addr, if *addr still holds val.
+// Checking the value and going to sleep happen under ptable.lock, which
+// futex_wake also takes, so a wake after the caller changed *addr is
+// never lost. Returns 0 when woken, -1 if *addr != val or the process
+// was killed; callers re-check their condition either way.
+int futex_wait(int *addr, int val)
+{
+  struct proc *p = myproc();
+  int *word;
+
+  acquire(&ptable.lock);
+  if ((word = futexword(p, addr)) == 0 || *word != val)
+  {
+    release(&ptable.lock);
+    return -1;
+  }
+  sleep(addr, &ptable.lock);
+  release(&ptable.lock);
+  return p->killed ? -1 : 0;
+}
+
+// Wake at most n threads waiting in futex_wait on addr. Only threads
+// of the current process can share its pages, so only they are looked
+// at. Returns the number woken.
+int futex_wake(int *addr, int n)
+{
+  struct proc *p = myproc();
+  struct thread *t;
+  int woken;
+
+  acquire(&ptable.lock);
+  if (futexword(p, addr) == 0)
+  {
+    release(&ptable.lock);
+    return -1;
+  }
+  woken = 0;
+  for (t = p->thrlist.thread; t < &p->thrlist.thread[NTHR] && woken < n; t++)
+  {
+    if (t->thr_state == THR_SLEEPING && t->chan == addr)
+    {
+      setrunnable(t);
+      woken++;
+    }
+  }
+  release(&ptable.lock);
+  return woken;
+}
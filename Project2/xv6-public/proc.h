@@ -9,7 +9,9 @@ struct cpu
   int ncli;                  // Depth of pushcli nesting.
   int intena;                // Were interrupts enabled before pushcli?
   struct proc *proc;         // The process running on this cpu or null
-  struct thread *thr;
+  struct thread *thr;        // The thread running on this cpu or null
+  volatile uint tlbflushreq; // Another cpu asked for a TLB flush (see shootdown)
+  volatile uint tlbflushes;  // TLB flushes done for such requests
 };
 
 extern struct cpu cpus[NCPU];
@@ -49,12 +51,17 @@ struct thread
   char *kstack;               // 쓰레드의 커널스택
   enum threadstate thr_state; // 쓰레드 상태
   struct trapframe *tf;       // Trap frame for current syscall
-  struct context *context;    // swtch() here to run process
+  struct context *context;    // swtch() here to run this thread
   void *chan;                 // If non-zero, sleeping on chan
-  int pid;                    // Process ID
-  uint tid;                   // thread ID
+  struct proc *proc;          // 이 쓰레드가 속한 프로세스
+  uint tid;                   // thread ID, 하위 비트는 thrlist에서의 위치 (tidthread)
   void *retval;               // 리턴값
-  uint execVisited;           //exec system call을 실행했는지
+  struct thread *joiner;      // thread_join으로 이 쓰레드를 기다리는 쓰레드
+  uint ustack;                // 가드 페이지부터 두 페이지짜리 유저 스택, 0이면 없음
+  uint tls;                   // 유저 공간의 TLS 블록 주소, SEG_UTLS의 base
+  struct thread *qnext;       // THR_RUNNABLE인 동안 실행 큐에서 다음 쓰레드
+  uint ticks;                 // 이 쓰레드가 돈 타이머 틱 수
+  uint nsyscall;              // 이 쓰레드가 부른 시스템 콜 수
 };
 
 enum procstate
@@ -72,13 +79,10 @@ struct proc
 {
   uint sz;                    // Size of process memory (bytes)
   pde_t *pgdir;               // Page table
-  char *kstack;               // Bottom of kernel stack for this process
-  enum procstate state;       // Process state
+  enum procstate state;       // EMBRYO, RUNNABLE or ZOMBIE; threads run, not procs
   int pid;                    // Process ID
   struct proc *parent;        // Parent process
-  struct trapframe *tf;       // Trap frame for current syscall
-  struct context *context;    // swtch() here to run process
-  int killed;                 // If non-zero, have been killed
+  int killed;                 // If non-zero, have been killed (EXECKILL: see exec)
   struct file *ofile[NOFILE]; // Open files
   struct inode *cwd;          // Current directory
   char name[16];              // Process name (debugging)
@@ -87,10 +91,19 @@ struct proc
     struct thread thread[NTHR];
   } thrlist;
   uint nexttid; // 다음번에 올 tid번호
-  uint curThrIdx;  // 현재 돌고있는 thread가 thrlist에서 몇번째인지
-  int limit;     //메모리 사이즈
+  int nthread;  // 아직 좀비가 되지 않은 쓰레드 수
+  int limit;     // 하드 제한: 상주 메모리(바이트), 넘는 할당은 실패. 0이면 제한 없음
+  int softlimit; // 소프트 제한: 넘으면 쓰레드 슬롯에 캐시된 스택을 회수. 0이면 없음
+  uint rss;      // 페이지 테이블이 매핑한 페이지 수, 테이블 포함 (uvmpages와 같은 값)
+  uint ticks;    // 끝난 쓰레드들이 돈 타이머 틱 수의 합
+  uint nsyscall; // 끝난 쓰레드들이 부른 시스템 콜 수의 합
 };
 
+// p->killed while exec() waits for the other threads of p to exit.
+// Those threads see it as killed; exec() puts it back to 0 afterwards
+// unless kill() set it to 1 in the meantime.
+#define EXECKILL 2
+
 // Process memory is laid out contiguously, low addresses first:
 //   text
 //   original data and bss
@@ -0,0 +1,25 @@
+// Snapshot of a process and its threads, as procinfo() fills it in.
+// Include param.h first.
+
+struct tstat {
+  int tid;
+  int state;       // enum threadstate in proc.h
+  uint ticks;      // timer ticks spent running
+  uint nsyscall;   // system calls made
+};
+
+struct pstat {
+  int pid;
+  int ppid;        // 0 if none
+  int state;       // enum procstate in proc.h
+  int killed;
+  char name[16];
+  uint sz;         // size of the address space in bytes
+  uint rss;        // pages of physical memory held
+  int limit;       // hard memory limit in bytes, 0 if none
+  int softlimit;   // soft memory limit in bytes, 0 if none
+  uint ticks;      // sum over all threads, exited ones included
+  uint nsyscall;   // likewise
+  int nthread;     // entries of thread[] in use
+  struct tstat thread[NTHR];
+};
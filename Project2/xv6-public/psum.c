@@ -0,0 +1,112 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+// Parallel sum benchmark for threads of one process.
+//   psum [maxthread] [n]
+// Sums an array of n ints (default 65536) with 1, 2, ... maxthread
+// threads (default 4), each taking an equal slice, and reports the
+// ticks each run took and its speedup over one thread. The array is
+// summed enough times over that one thread takes at least 100 ticks.
+// Threads run on every cpu at once, so the speedup should approach
+// the smaller of maxthread and the cpu count (make CPUS=n).
+
+#define MAXTHREAD 16
+#define MINTICKS 100
+
+int *data;
+int n;
+int nthread;
+int rounds;
+
+// One per thread, each in its own cache line so that threads on
+// different cpus do not write to a shared line.
+struct {
+  uint sum;
+  char pad[60];
+} part[MAXTHREAD];
+
+void *
+sumpart(void *arg)
+{
+  int id = (int)arg;
+  int lo = n * id / nthread;
+  int hi = n * (id + 1) / nthread;
+  int r, i;
+  uint s;
+
+  s = 0;
+  for(r = 0; r < rounds; r++)
+    for(i = lo; i < hi; i++)
+      s += data[i];
+  part[id].sum = s;
+  thread_exit(0);
+  return 0;
+}
+
+// Sum the array rounds times over with k threads and return the
+// ticks it took.
+int
+run(int k, uint expect)
+{
+  thread_t tid[MAXTHREAD];
+  void *ret;
+  int i, t0, t;
+  uint sum;
+
+  nthread = k;
+  t0 = uptime();
+  for(i = 0; i < k; i++){
+    if(thread_create(&tid[i], sumpart, (void*)i) < 0){
+      printf(2, "psum: thread_create failed\n");
+      exit();
+    }
+  }
+  for(i = 0; i < k; i++)
+    thread_join(tid[i], &ret);
+  t = uptime() - t0;
+
+  sum = 0;
+  for(i = 0; i < k; i++)
+    sum += part[i].sum;
+  if(sum != expect * rounds){
+    printf(2, "psum: %d threads got %d, want %d\n", k, sum, expect * rounds);
+    exit();
+  }
+  return t;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int maxthread, k, i, t, t1;
+  uint expect;
+
+  maxthread = argc > 1 ? atoi(argv[1]) : 4;
+  n = argc > 2 ? atoi(argv[2]) : 65536;
+  if(maxthread < 1 || maxthread > MAXTHREAD || n < 1){
+    printf(2, "usage: psum [maxthread (1-%d)] [n]\n", MAXTHREAD);
+    exit();
+  }
+  if((data = malloc(n * sizeof(int))) == 0){
+    printf(2, "psum: out of memory\n");
+    exit();
+  }
+  expect = 0;
+  for(i = 0; i < n; i++){
+    data[i] = i % 7;
+    expect += data[i];
+  }
+
+  rounds = 1;
+  while((t1 = run(1, expect)) < MINTICKS)
+    rounds *= 2;
+  printf(1, "%d ints, %d rounds\n", n, rounds);
+  printf(1, "threads\tticks\tspeedup (x100)\n");
+  printf(1, "1\t%d\t100\n", t1);
+  for(k = 2; k <= maxthread; k++){
+    t = run(k, expect);
+    printf(1, "%d\t%d\t%d\n", k, t, t ? t1 * 100 / t : 0);
+  }
+  exit();
+}
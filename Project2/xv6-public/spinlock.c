@@ -29,8 +29,10 @@ acquire(struct spinlock *lk)
     panic("acquire");
 
   // The xchg is atomic.
+  // The holder may be waiting for this cpu to flush its TLB,
+  // which the T_TLBFLUSH interrupt cannot do while we spin here.
   while(xchg(&lk->locked, 1) != 0)
-    ;
+    tlbpoll();
 
   // Tell the C compiler and the processor to not move loads or stores
   // past this point, to ensure that the critical section's memory
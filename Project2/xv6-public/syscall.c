@@ -13,6 +13,23 @@
 // library system call function. The saved user %esp points
 // to a saved program counter, and then the first argument.
 
+// Fault in n bytes at addr of the current process, which the caller
+// has checked, before the kernel uses them (see heapfault). Kills the
+// process if there is no memory for them.
+static int
+touch(uint addr, uint n)
+{
+  uint a;
+
+  for(a = PGROUNDDOWN(addr); a < addr + n; a += PGSIZE){
+    if(heapfault(a, 1) < 0){
+      myproc()->killed = 1;
+      return -1;
+    }
+  }
+  return 0;
+}
+
 // Fetch the int at addr from the current process.
 int
 fetchint(uint addr, int *ip)
@@ -21,6 +38,8 @@ fetchint(uint addr, int *ip)
 
   if(addr >= curproc->sz || addr+4 > curproc->sz)
     return -1;
+  if(touch(addr, 4) < 0)
+    return -1;
   *ip = *(int*)(addr);
   return 0;
 }
@@ -39,6 +58,8 @@ fetchstr(uint addr, char **pp)
   *pp = (char*)addr;
   ep = (char*)curproc->sz;
   for(s = *pp; s < ep; s++){
+    if((s == *pp || (uint)s % PGSIZE == 0) && touch((uint)s, 1) < 0)
+      return -1;
     if(*s == 0)
       return s - *pp;
   }
@@ -49,7 +70,7 @@ fetchstr(uint addr, char **pp)
 int
 argint(int n, int *ip)
 {
-  return fetchint((myproc()->tf->esp) + 4 + 4*n, ip);
+  return fetchint((mythread()->tf->esp) + 4 + 4*n, ip);
 }
 
 // Fetch the nth word-sized system call argument as a pointer
@@ -65,6 +86,8 @@ argptr(int n, char **pp, int size)
     return -1;
   if(size < 0 || (uint)i >= curproc->sz || (uint)i+size > curproc->sz)
     return -1;
+  if(touch(i, size) < 0)
+    return -1;
   *pp = (char*)i;
   return 0;
 }
@@ -109,6 +132,10 @@ extern int sys_thread_create(void);
 extern int sys_thread_exit(void);
 extern int sys_thread_join(void);
 extern int sys_list_info(void);
+extern int sys_futex_wait(void);
+extern int sys_futex_wake(void);
+extern int sys_setmemorysoftlimit(void);
+extern int sys_procinfo(void);
 
 static int (*syscalls[])(void) = {
 [SYS_fork]    sys_fork,
@@ -138,6 +165,10 @@ static int (*syscalls[])(void) = {
 [SYS_thread_exit]     sys_thread_exit,
 [SYS_thread_join]     sys_thread_join,
 [SYS_list_info]       sys_list_info,
+[SYS_futex_wait]      sys_futex_wait,
+[SYS_futex_wake]      sys_futex_wake,
+[SYS_setmemorysoftlimit] sys_setmemorysoftlimit,
+[SYS_procinfo]        sys_procinfo,
 };
 
 void
@@ -145,13 +176,15 @@ syscall(void)
 {
   int num;
   struct proc *curproc = myproc();
+  struct thread *curthr = mythread();
 
-  num = curproc->tf->eax;
+  num = curthr->tf->eax;
+  curthr->nsyscall++;
   if(num > 0 && num < NELEM(syscalls) && syscalls[num]) {
-    curproc->tf->eax = syscalls[num]();
+    curthr->tf->eax = syscalls[num]();
   } else {
     cprintf("%d %s: unknown sys call %d\n",
             curproc->pid, curproc->name, num);
-    curproc->tf->eax = -1;
+    curthr->tf->eax = -1;
   }
 }
@@ -25,4 +25,8 @@
 #define SYS_thread_create   24
 #define SYS_thread_exit     25
 #define SYS_thread_join     26
-#define SYS_list_info       27
\ No newline at end of file
+#define SYS_list_info       27
+#define SYS_futex_wait      28
+#define SYS_futex_wake      29
+#define SYS_setmemorysoftlimit 30
+#define SYS_procinfo        31
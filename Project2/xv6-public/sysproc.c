@@ -6,6 +6,7 @@
 #include "memlayout.h"
 #include "mmu.h"
 #include "proc.h"
+#include "pstat.h"
 
 int
 sys_fork(void)
@@ -50,8 +51,7 @@ sys_sbrk(void)
 
   if(argint(0, &n) < 0)
     return -1;
-  addr = myproc()->sz;
-  if(growproc(n) < 0)
+  if((addr = growproc(n)) < 0)
     return -1;
   return addr;
 }
@@ -102,6 +102,18 @@ sys_setmemorylimit(void)
   return setmemorylimit(pid,limit);
 }
 
+int
+sys_setmemorysoftlimit(void)
+{
+  int pid;
+  int limit;
+
+  if (argint(0,&pid)<0 || argint(1,&limit)<0) {
+    return -1;
+  }
+  return setmemorysoftlimit(pid,limit);
+}
+
 int
 sys_thread_create(void)
 {
@@ -147,4 +159,40 @@ int sys_list_info(void)
 {
   list_info();
   return 1;
-}
\ No newline at end of file
+}
+
+int
+sys_procinfo(void)
+{
+  struct pstat *buf;
+  int n;
+
+  if (argint(1, &n) < 0 || n < 0)
+    return -1;
+  if (n > NPROC)
+    n = NPROC;
+  if (argptr(0, (char**)&buf, n * sizeof(*buf)) < 0)
+    return -1;
+  return procinfo(buf, n);
+}
+int
+sys_futex_wait(void)
+{
+  int *addr;
+  int val;
+
+  if (argptr(0, (char**)&addr, sizeof *addr) < 0 || argint(1, &val) < 0)
+    return -1;
+  return futex_wait(addr, val);
+}
+
+int
+sys_futex_wake(void)
+{
+  int *addr;
+  int n;
+
+  if (argptr(0, (char**)&addr, sizeof *addr) < 0 || argint(1, &n) < 0)
+    return -1;
+  return futex_wake(addr, n);
+}
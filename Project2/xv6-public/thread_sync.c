@@ -0,0 +1,156 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define NUM_THREAD 8
+#define NUM_INCR 20000
+#define NUM_ITEM 2000
+#define NUM_PHASE 50
+#define BUFSIZE 4
+
+thread_t thread[NUM_THREAD];
+
+mutex_t lock;
+int counter;
+
+cond_t notfull, notempty;
+int buf[BUFSIZE];
+int head, tail, used;
+int consumed;
+
+barrier_t barrier;
+int arrived[NUM_PHASE];
+
+void failed()
+{
+  printf(1, "Test failed!\n");
+  exit();
+}
+
+void *thread_mutex(void *arg)
+{
+  int i;
+  for (i = 0; i < NUM_INCR; i++) {
+    mutex_lock(&lock);
+    counter++;
+    mutex_unlock(&lock);
+  }
+  thread_exit(arg);
+  return 0;
+}
+
+void *thread_producer(void *arg)
+{
+  int i;
+  for (i = 1; i <= NUM_ITEM; i++) {
+    mutex_lock(&lock);
+    while (used == BUFSIZE)
+      cond_wait(&notfull, &lock);
+    buf[tail] = i;
+    tail = (tail + 1) % BUFSIZE;
+    used++;
+    cond_signal(&notempty);
+    mutex_unlock(&lock);
+  }
+  thread_exit(arg);
+  return 0;
+}
+
+void *thread_consumer(void *arg)
+{
+  int i, item;
+  for (i = 0; i < NUM_ITEM; i++) {
+    mutex_lock(&lock);
+    while (used == 0)
+      cond_wait(&notempty, &lock);
+    item = buf[head];
+    head = (head + 1) % BUFSIZE;
+    used--;
+    consumed += item;
+    cond_signal(&notfull);
+    mutex_unlock(&lock);
+  }
+  thread_exit(arg);
+  return 0;
+}
+
+void *thread_barrier(void *arg)
+{
+  int i;
+  for (i = 0; i < NUM_PHASE; i++) {
+    __sync_fetch_and_add(&arrived[i], 1);
+    barrier_wait(&barrier);
+    if (arrived[i] != NUM_THREAD) {
+      printf(1, "Phase %d: passed the barrier with %d of %d threads\n", i, arrived[i], NUM_THREAD);
+      failed();
+    }
+  }
+  thread_exit(arg);
+  return 0;
+}
+
+void create_all(int n, void *(*entry)(void *))
+{
+  int i;
+  for (i = 0; i < n; i++) {
+    if (thread_create(&thread[i], entry, (void *)i) != 0) {
+      printf(1, "Error creating thread %d\n", i);
+      failed();
+    }
+  }
+}
+
+void join_all(int n)
+{
+  int i;
+  void *retval;
+  for (i = 0; i < n; i++) {
+    if (thread_join(thread[i], &retval) != 0) {
+      printf(1, "Error joining thread %d\n", i);
+      failed();
+    }
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  int i, start;
+
+  printf(1, "Test 1: Mutex test\n");
+  start = uptime();
+  create_all(NUM_THREAD, thread_mutex);
+  join_all(NUM_THREAD);
+  if (counter != NUM_THREAD * NUM_INCR) {
+    printf(1, "Counter is %d, expected %d\n", counter, NUM_THREAD * NUM_INCR);
+    failed();
+  }
+  printf(1, "Test 1 passed in %d ticks\n\n", uptime() - start);
+
+  printf(1, "Test 2: Condition variable test\n");
+  if (thread_create(&thread[0], thread_producer, 0) != 0 ||
+      thread_create(&thread[1], thread_consumer, 0) != 0) {
+    printf(1, "Error creating threads\n");
+    failed();
+  }
+  join_all(2);
+  if (consumed != NUM_ITEM * (NUM_ITEM + 1) / 2) {
+    printf(1, "Consumed %d, expected %d\n", consumed, NUM_ITEM * (NUM_ITEM + 1) / 2);
+    failed();
+  }
+  printf(1, "Test 2 passed\n\n");
+
+  printf(1, "Test 3: Barrier test\n");
+  barrier_init(&barrier, NUM_THREAD);
+  create_all(NUM_THREAD, thread_barrier);
+  join_all(NUM_THREAD);
+  for (i = 0; i < NUM_PHASE; i++) {
+    if (arrived[i] != NUM_THREAD) {
+      printf(1, "Phase %d: %d threads arrived\n", i, arrived[i]);
+      failed();
+    }
+  }
+  printf(1, "Test 3 passed\n\n");
+
+  printf(1, "All tests passed!\n");
+  exit();
+}
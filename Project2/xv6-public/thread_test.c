@@ -99,6 +99,12 @@ void *thread_sbrk(void *arg)
   thread_exit(arg);
   return 0;
 }
+void *thread_churn(void *arg)
+{
+  thread_exit(arg);
+  return 0;
+}
+
 void create_all(int n, void *(*entry)(void *))
 {
   int i;
@@ -161,6 +167,20 @@ int main(int argc, char *argv[])
   join_all(NUM_THREAD);
   printf(1, "Test 3 passed\n\n");
 
+  printf(1, "Test 4: Churn test\n");
+  create_all(NUM_THREAD, thread_churn);
+  join_all(NUM_THREAD);
+  char *top = sbrk(0);
+  for (i = 0; i < 1000; i++) {
+    create_all(NUM_THREAD, thread_churn);
+    join_all(NUM_THREAD);
+  }
+  if (sbrk(0) != top) {
+    printf(1, "Process grew from %d to %d bytes creating and joining threads\n", top, sbrk(0));
+    failed();
+  }
+  printf(1, "Test 4 passed\n\n");
+
   printf(1, "All tests passed!\n");
   exit();
 }
@@ -0,0 +1,119 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define NUM_THREAD 8
+
+thread_t thread[NUM_THREAD];
+thread_t seen[NUM_THREAD];
+struct tls *blocks[NUM_THREAD];
+
+void failed()
+{
+  printf(1, "Test failed!\n");
+  exit();
+}
+
+void *thread_tls(void *arg)
+{
+  int val = (int)arg;
+  struct tls *t = tls();
+  int i;
+
+  if (t->self != t) {
+    printf(1, "Thread %d: TLS self pointer is wrong\n", val);
+    failed();
+  }
+  for (i = 0; i < TLS_NSLOT; i++) {
+    if (t->slot[i] != 0) {
+      printf(1, "Thread %d: TLS slot %d starts as %d\n", val, i, t->slot[i]);
+      failed();
+    }
+  }
+  seen[val] = t->tid;
+  blocks[val] = t;
+  for (i = 0; i < 20; i++) {
+    tls()->slot[0] = (void *)(val * 1000 + i);
+    sleep(1);
+    if (tls()->slot[0] != (void *)(val * 1000 + i)) {
+      printf(1, "Thread %d: TLS was overwritten by another thread\n", val);
+      failed();
+    }
+  }
+  // 다음 쓰레드가 같은 스택을 물려받아도 TLS는 깨끗해야 한다.
+  tls()->slot[1] = (void *)1;
+  thread_exit(arg);
+  return 0;
+}
+
+void create_all(int n, void *(*entry)(void *))
+{
+  int i;
+  for (i = 0; i < n; i++) {
+    if (thread_create(&thread[i], entry, (void *)i) != 0) {
+      printf(1, "Error creating thread %d\n", i);
+      failed();
+    }
+  }
+}
+
+void join_all(int n)
+{
+  int i;
+  void *retval;
+  for (i = 0; i < n; i++) {
+    if (thread_join(thread[i], &retval) != 0) {
+      printf(1, "Error joining thread %d\n", i);
+      failed();
+    }
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  int i, j, pid;
+
+  printf(1, "Test 1: Main thread TLS\n");
+  if (tls()->self != tls()) {
+    printf(1, "Main thread TLS self pointer is wrong\n");
+    failed();
+  }
+  printf(1, "Test 1 passed\n\n");
+
+  printf(1, "Test 2: Per-thread TLS\n");
+  for (j = 0; j < 2; j++) {
+    create_all(NUM_THREAD, thread_tls);
+    join_all(NUM_THREAD);
+    for (i = 0; i < NUM_THREAD; i++) {
+      if (seen[i] != thread[i]) {
+        printf(1, "Thread %d saw tid %d in TLS, but thread_create returned %d\n", i, seen[i], thread[i]);
+        failed();
+      }
+      if (blocks[i] == tls() || (i > 0 && blocks[i] == blocks[i - 1])) {
+        printf(1, "Thread %d shares its TLS block\n", i);
+        failed();
+      }
+    }
+  }
+  printf(1, "Test 2 passed\n\n");
+
+  printf(1, "Test 3: Fork test\n");
+  tls()->slot[0] = (void *)1234;
+  pid = fork();
+  if (pid < 0) {
+    printf(1, "Fork error\n");
+    failed();
+  }
+  if (pid == 0) {
+    if (tls()->slot[0] != (void *)1234) {
+      printf(1, "Child lost the TLS of the thread that forked\n");
+      failed();
+    }
+    exit();
+  }
+  wait();
+  printf(1, "Test 3 passed\n\n");
+
+  printf(1, "All tests passed!\n");
+  exit();
+}
@@ -0,0 +1,91 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+// Thread pool benchmark.
+//   tpbench [ntask] [work] [nworker]
+// Runs ntask small tasks (default 2000), each summing work numbers
+// (default 1000), first by creating and joining a thread per task,
+// nworker at a time (default 4), then on a pool of nworker workers,
+// and prints the ticks each way took. The smaller the tasks, the more
+// of the first run goes to thread creation and joining.
+
+#define MAXTASK 10000
+
+int work;
+int results[MAXTASK];
+future_t futures[MAXTASK];
+
+void*
+task(void *arg)
+{
+  int i, s;
+
+  s = 0;
+  for(i = 0; i < work; i++)
+    s += i ^ (int)arg;
+  results[(int)arg] = s;
+  return (void*)s;
+}
+
+void*
+spawned(void *arg)
+{
+  task(arg);
+  thread_exit(0);
+  return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+  thread_t tid[TPOOL_MAXWORKER];
+  tpool_t pool;
+  void *ret;
+  int ntask, nworker, i, j, n, t0, tspawn, tpool;
+
+  ntask = argc > 1 ? atoi(argv[1]) : 2000;
+  work = argc > 2 ? atoi(argv[2]) : 1000;
+  nworker = argc > 3 ? atoi(argv[3]) : 4;
+  if(ntask < 1 || ntask > MAXTASK || work < 0 ||
+     nworker < 1 || nworker > TPOOL_MAXWORKER){
+    printf(2, "usage: tpbench [ntask (1-%d)] [work] [nworker (1-%d)]\n",
+           MAXTASK, TPOOL_MAXWORKER);
+    exit();
+  }
+
+  t0 = uptime();
+  for(i = 0; i < ntask; i += n){
+    n = ntask - i < nworker ? ntask - i : nworker;
+    for(j = 0; j < n; j++){
+      if(thread_create(&tid[j], spawned, (void*)(i + j)) < 0){
+        printf(2, "tpbench: thread_create failed\n");
+        exit();
+      }
+    }
+    for(j = 0; j < n; j++)
+      thread_join(tid[j], &ret);
+  }
+  tspawn = uptime() - t0;
+
+  t0 = uptime();
+  if(tpool_init(&pool, nworker) < 0){
+    printf(2, "tpbench: tpool_init failed\n");
+    exit();
+  }
+  for(i = 0; i < ntask; i++)
+    tpool_submit(&pool, task, (void*)i, &futures[i]);
+  for(i = 0; i < ntask; i++){
+    if((int)future_get(&futures[i]) != results[i]){
+      printf(2, "tpbench: task %d returned a wrong result\n", i);
+      exit();
+    }
+  }
+  tpool_destroy(&pool);
+  tpool = uptime() - t0;
+
+  printf(1, "%d tasks of %d, %d threads at a time\n", ntask, work, nworker);
+  printf(1, "spawn per task\t%d ticks\n", tspawn);
+  printf(1, "thread pool\t%d ticks\n", tpool);
+  exit();
+}
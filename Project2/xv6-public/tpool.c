@@ -0,0 +1,185 @@
+#include "types.h"
+#include "user.h"
+#include "param.h"
+#include "x86.h"
+
+// Thread pool. tpool_init starts a fixed set of workers, which take
+// tasks from a bounded multi-producer, multi-consumer ring: each cell
+// carries a sequence number saying which lap of the ring it is ready
+// for, so producers and consumers claim cells with one compare-and-swap
+// on tail or head and never take a lock. Workers that find the ring
+// empty sleep in futex_wait on the pending count, and future_get sleeps
+// on the future until its task is done.
+
+#define barrier() asm volatile("" : : : "memory")
+
+// Put a task in the ring. Returns -1 if the ring is full.
+static int
+enqueue(tpool_t *p, void *(*fn)(void*), void *arg, future_t *f)
+{
+  struct tpool_cell *c;
+  uint pos;
+  int dif;
+
+  pos = p->tail;
+  for(;;){
+    c = &p->cell[pos & (TPOOL_QSIZE - 1)];
+    dif = (int)c->seq - (int)pos;
+    if(dif == 0){
+      if(__sync_val_compare_and_swap(&p->tail, pos, pos + 1) == pos)
+        break;
+    } else if(dif < 0)
+      return -1;
+    pos = p->tail;
+  }
+  c->fn = fn;
+  c->arg = arg;
+  c->future = f;
+  barrier();
+  c->seq = pos + 1;
+  return 0;
+}
+
+// Take a task from the ring. Returns -1 if the ring is empty.
+static int
+dequeue(tpool_t *p, void *(**fn)(void*), void **arg, future_t **f)
+{
+  struct tpool_cell *c;
+  uint pos;
+  int dif;
+
+  pos = p->head;
+  for(;;){
+    c = &p->cell[pos & (TPOOL_QSIZE - 1)];
+    dif = (int)c->seq - (int)(pos + 1);
+    if(dif == 0){
+      if(__sync_val_compare_and_swap(&p->head, pos, pos + 1) == pos)
+        break;
+    } else if(dif < 0)
+      return -1;
+    pos = p->head;
+  }
+  *fn = c->fn;
+  *arg = c->arg;
+  *f = c->future;
+  barrier();
+  c->seq = pos + TPOOL_QSIZE;
+  return 0;
+}
+
+static void
+runtask(void *(*fn)(void*), void *arg, future_t *f)
+{
+  void *r;
+
+  r = fn(arg);
+  if(f == 0)
+    return;
+  f->result = r;
+  if(xchg((volatile uint*)&f->state, 1) == 2)
+    futex_wake((int*)&f->state, NTHR);
+}
+
+static void*
+worker(void *arg)
+{
+  tpool_t *p = arg;
+  void *(*fn)(void*);
+  void *a;
+  future_t *f;
+
+  for(;;){
+    if(dequeue(p, &fn, &a, &f) == 0){
+      __sync_fetch_and_sub(&p->pending, 1);
+      runtask(fn, a, f);
+      continue;
+    }
+    if(p->stop)
+      break;
+    // Announce ourselves before looking at pending once more:
+    // tpool_submit bumps pending before it looks at idle, so one of
+    // the two always sees the other.
+    __sync_fetch_and_add(&p->idle, 1);
+    if(p->pending == 0 && !p->stop)
+      futex_wait((int*)&p->pending, 0);
+    __sync_fetch_and_sub(&p->idle, 1);
+  }
+  thread_exit(0);
+  return 0;
+}
+
+// Start nworker workers on p. Returns -1 if not all could be started,
+// in which case none are left running.
+int
+tpool_init(tpool_t *p, int nworker)
+{
+  int i;
+
+  if(nworker < 1 || nworker > TPOOL_MAXWORKER)
+    return -1;
+  memset(p, 0, sizeof(*p));
+  for(i = 0; i < TPOOL_QSIZE; i++)
+    p->cell[i].seq = i;
+  for(p->nworker = 0; p->nworker < nworker; p->nworker++){
+    if(thread_create(&p->worker[p->nworker], worker, p) < 0){
+      tpool_destroy(p);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// Queue fn(arg) to run on a worker. If f is not null, future_get(f)
+// returns what fn returned. When the ring is full the caller runs a
+// queued task itself instead of waiting for room.
+int
+tpool_submit(tpool_t *p, void *(*fn)(void*), void *arg, future_t *f)
+{
+  void *(*qfn)(void*);
+  void *qarg;
+  future_t *qf;
+
+  if(f){
+    f->state = 0;
+    f->result = 0;
+  }
+  while(enqueue(p, fn, arg, f) < 0){
+    if(dequeue(p, &qfn, &qarg, &qf) == 0){
+      __sync_fetch_and_sub(&p->pending, 1);
+      runtask(qfn, qarg, qf);
+    }
+  }
+  __sync_fetch_and_add(&p->pending, 1);
+  if(p->idle > 0)
+    futex_wake((int*)&p->pending, 1);
+  return 0;
+}
+
+// Wait for f's task to finish and return its result.
+void*
+future_get(future_t *f)
+{
+  while(f->state != 1){
+    if(__sync_val_compare_and_swap(&f->state, 0, 2) == 1)
+      break;
+    futex_wait((int*)&f->state, 2);
+  }
+  return f->result;
+}
+
+// Let the workers finish the tasks already queued, then stop them.
+void
+tpool_destroy(tpool_t *p)
+{
+  void *ret;
+  int i;
+
+  p->stop = 1;
+  // Change the word the workers sleep on too, so that one about to
+  // sleep on pending == 0 does not miss the wakeup.
+  __sync_fetch_and_add(&p->pending, 1);
+  futex_wake((int*)&p->pending, NTHR);
+  for(i = 0; i < p->nworker; i++)
+    thread_join(p->worker[i], &ret);
+  p->nworker = 0;
+}
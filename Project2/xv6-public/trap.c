@@ -39,7 +39,7 @@ trap(struct trapframe *tf)
   if(tf->trapno == T_SYSCALL){
     if(myproc()->killed)
       exit();
-    myproc()->tf = tf;
+    mythread()->tf = tf;
     syscall();
     if(myproc()->killed)
       exit();
@@ -54,6 +54,13 @@ trap(struct trapframe *tf)
       wakeup(&ticks);
       release(&tickslock);
     }
+    // Charge the tick to the thread this cpu was running.
+    if(mythread())
+      mythread()->ticks++;
+    lapiceoi();
+    break;
+  case T_TLBFLUSH:
+    tlbpoll();
     lapiceoi();
     break;
   case T_IRQ0 + IRQ_IDE:
@@ -77,6 +84,17 @@ trap(struct trapframe *tf)
             cpuid(), tf->cs, tf->eip);
     lapiceoi();
     break;
+  case T_PGFLT:
+    // Heap that sbrk made room for but nothing has touched yet (see
+    // heapfault), or a write to a page shared copy-on-write since fork
+    // (see copyuvm). In the kernel, this is a system call using user
+    // memory it did not fault in beforehand (see argptr), like
+    // thread_join storing *retval.
+    if(myproc() && !(tf->err & 1) && heapfault(rcr2(), (tf->cs&3) == 0) == 0)
+      break;
+    if(myproc() && (tf->err & 2) && cowfault(myproc()->pgdir, rcr2()) == 0)
+      break;
+    // fall through
 
   //PAGEBREAK: 13
   default:
@@ -102,7 +120,7 @@ trap(struct trapframe *tf)
 
   // Force process to give up CPU on clock tick.
   // If interrupts were on while locks held, would need to check nlock.
-  if(myproc() && myproc()->state == RUNNING &&
+  if(mythread() && mythread()->thr_state == THR_RUNNING &&
      tf->trapno == T_IRQ0+IRQ_TIMER)
     yield();
 
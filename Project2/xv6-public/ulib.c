@@ -2,6 +2,7 @@
 #include "stat.h"
 #include "fcntl.h"
 #include "user.h"
+#include "param.h"
 #include "x86.h"
 
 char*
@@ -104,3 +105,92 @@ memmove(void *vdst, const void *vsrc, int n)
     *dst++ = *src++;
   return vdst;
 }
+
+// Mutexes, condition variables and barriers for threads. Uncontended
+// operations stay in user space; a thread that has to wait sleeps in
+// futex_wait instead of spinning away its time slices.
+
+void
+mutex_lock(mutex_t *m)
+{
+  int c;
+
+  if((c = __sync_val_compare_and_swap(&m->state, 0, 1)) == 0)
+    return;
+  // Mark the mutex contended before sleeping, so that the holder
+  // knows to wake someone when it unlocks.
+  if(c != 2)
+    c = xchg((volatile uint*)&m->state, 2);
+  while(c != 0){
+    futex_wait((int*)&m->state, 2);
+    c = xchg((volatile uint*)&m->state, 2);
+  }
+}
+
+void
+mutex_unlock(mutex_t *m)
+{
+  if(__sync_fetch_and_sub(&m->state, 1) != 1){
+    m->state = 0;
+    futex_wake((int*)&m->state, 1);
+  }
+}
+
+void
+cond_wait(cond_t *c, mutex_t *m)
+{
+  int seq;
+
+  seq = c->seq;
+  mutex_unlock(m);
+  futex_wait((int*)&c->seq, seq);
+  mutex_lock(m);
+}
+
+void
+cond_signal(cond_t *c)
+{
+  __sync_fetch_and_add(&c->seq, 1);
+  futex_wake((int*)&c->seq, 1);
+}
+
+void
+cond_broadcast(cond_t *c)
+{
+  __sync_fetch_and_add(&c->seq, 1);
+  futex_wake((int*)&c->seq, NTHR);
+}
+
+void
+barrier_init(barrier_t *b, int n)
+{
+  memset(b, 0, sizeof(*b));
+  b->n = n;
+}
+
+void
+barrier_wait(barrier_t *b)
+{
+  int gen;
+
+  mutex_lock(&b->lock);
+  gen = b->gen;
+  if(++b->count == b->n){
+    b->count = 0;
+    b->gen++;
+    cond_broadcast(&b->cond);
+  } else {
+    while(gen == b->gen)
+      cond_wait(&b->cond, &b->lock);
+  }
+  mutex_unlock(&b->lock);
+}
+
+struct tls*
+tls(void)
+{
+  struct tls *t;
+
+  asm volatile("movl %%gs:0, %0" : "=r" (t));
+  return t;
+}
@@ -2,89 +2,293 @@
 #include "stat.h"
 #include "user.h"
 #include "param.h"
+#include "mmu.h"
 
-// Memory allocator by Kernighan and Ritchie,
-// The C programming Language, 2nd ed.  Section 8.7.
+// Memory allocator for processes with threads.
+//
+// Requests up to MAXSMALL bytes are rounded up to a size class and
+// served from slabs: pages cut into objects of one class. Each thread
+// keeps a cache of free objects per class, found through its TLS
+// block, so most calls touch no lock at all. Caches refill from and
+// overflow to a central depot, one list and one mutex per class,
+// BATCH objects at a time; the depot cuts a new slab when it runs dry.
+// Larger requests get whole pages from an address-ordered list of free
+// blocks, merged with their neighbours when freed.
+//
+// Every slab and big block starts on a page boundary with a struct
+// slab, so free() finds the header of any object by rounding its
+// address down. Memory comes from sbrk, so setmemorylimit applies, and
+// is never given back to the kernel.
 
-typedef long Align;
+#define MINSHIFT  4     // smallest class is 16 bytes
+#define NCLASS    7     // 16, 32, ... 1024
+#define MAXSMALL  (1 << (MINSHIFT + NCLASS - 1))
+#define BATCH     16    // objects moved between a cache and the depot
+#define SLABMAGIC 0x51ab51ab
+#define BIGMAGIC  0xb16b10c5
 
-union header {
-  struct {
-    union header *ptr;
-    uint size;
-  } s;
-  Align x;
+struct object {
+  struct object *next;
 };
 
-typedef union header Header;
+// Header at the start of every page the allocator gets from sbrk
+// for a slab, and of every big block.
+struct slab {
+  uint magic;
+  uint class;           // slabs: size class of the objects
+  uint npages;          // big blocks: length in pages
+  struct slab *next;    // big blocks: next free block
+};
 
-static Header base;
-static Header *freep;
+struct tcache {
+  struct object *head[NCLASS];
+  int count[NCLASS];
+};
 
-void
-free(void *ap)
+static struct {
+  mutex_t lock;
+  struct object *head;
+} depot[NCLASS];
+
+static mutex_t heaplock;        // sbrk and the big block list
+static struct slab *bigfree;    // free big blocks, by address
+
+void _thread_exit(void*);       // the system call itself, in usys.S
+
+static int
+sizeclass(uint nbytes)
 {
-  Header *bp, *p;
-
-  bp = (Header*)ap - 1;
-  for(p = freep; !(bp > p && bp < p->s.ptr); p = p->s.ptr)
-    if(p >= p->s.ptr && (bp > p || bp < p->s.ptr))
-      break;
-  if(bp + bp->s.size == p->s.ptr){
-    bp->s.size += p->s.ptr->s.size;
-    bp->s.ptr = p->s.ptr->s.ptr;
-  } else
-    bp->s.ptr = p->s.ptr;
-  if(p + p->s.size == bp){
-    p->s.size += bp->s.size;
-    p->s.ptr = bp->s.ptr;
-  } else
-    p->s.ptr = bp;
-  freep = p;
+  int c;
+
+  for(c = 0; (1 << (MINSHIFT + c)) < nbytes; c++)
+    ;
+  return c;
+}
+
+// Get n pages from the kernel, starting on a page boundary.
+// Caller holds heaplock.
+static struct slab*
+morepages(uint n)
+{
+  uint brk;
+  char *p;
+
+  brk = (uint)sbrk(0);
+  if(brk % PGSIZE && sbrk(PGSIZE - brk % PGSIZE) == (char*)-1)
+    return 0;
+  if((p = sbrk(n * PGSIZE)) == (char*)-1)
+    return 0;
+  return (struct slab*)p;
 }
 
-static Header*
-morecore(uint nu)
+// Cut a new slab into objects of class c and add them to the depot.
+// Caller holds depot[c].lock.
+static int
+newslab(int c)
 {
+  struct slab *s;
+  struct object *o;
+  uint size;
   char *p;
-  Header *hp;
 
-  if(nu < 4096)
-    nu = 4096;
-  p = sbrk(nu * sizeof(Header));
-  if(p == (char*)-1)
+  mutex_lock(&heaplock);
+  s = morepages(1);
+  mutex_unlock(&heaplock);
+  if(s == 0)
+    return -1;
+  s->magic = SLABMAGIC;
+  s->class = c;
+  size = 1 << (MINSHIFT + c);
+  for(p = (char*)(s + 1); p + size <= (char*)s + PGSIZE; p += size){
+    o = (struct object*)p;
+    o->next = depot[c].head;
+    depot[c].head = o;
+  }
+  return 0;
+}
+
+// Take up to max objects of class c from the depot and chain them on
+// *list. Returns how many, 0 if out of memory.
+static int
+depotget(int c, struct object **list, int max)
+{
+  struct object *o;
+  int n;
+
+  mutex_lock(&depot[c].lock);
+  if(depot[c].head == 0 && newslab(c) < 0){
+    mutex_unlock(&depot[c].lock);
+    return 0;
+  }
+  o = *list = depot[c].head;
+  for(n = 1; n < max && o->next; n++)
+    o = o->next;
+  depot[c].head = o->next;
+  o->next = 0;
+  mutex_unlock(&depot[c].lock);
+  return n;
+}
+
+// Give the chain head..tail of class c objects to the depot.
+static void
+depotput(int c, struct object *head, struct object *tail)
+{
+  mutex_lock(&depot[c].lock);
+  tail->next = depot[c].head;
+  depot[c].head = head;
+  mutex_unlock(&depot[c].lock);
+}
+
+// The calling thread's cache, made on first use. Returns 0 if there
+// is no memory for one; the caller then goes to the depot directly.
+static struct tcache*
+mycache(void)
+{
+  struct tls *t = tls();
+  struct object *o;
+
+  if(t->slot[TLS_MALLOC] == 0){
+    if(depotget(sizeclass(sizeof(struct tcache)), &o, 1) == 0)
+      return 0;
+    memset(o, 0, sizeof(struct tcache));
+    t->slot[TLS_MALLOC] = o;
+  }
+  return t->slot[TLS_MALLOC];
+}
+
+static void*
+bigalloc(uint nbytes)
+{
+  struct slab *s, *rest, **pp;
+  uint npages;
+
+  if(nbytes > 0x40000000)
     return 0;
-  hp = (Header*)p;
-  hp->s.size = nu;
-  free((void*)(hp + 1));
-  return freep;
+  npages = (nbytes + sizeof(struct slab) + PGSIZE - 1) / PGSIZE;
+  mutex_lock(&heaplock);
+  for(pp = &bigfree; (s = *pp) != 0; pp = &s->next){
+    if(s->npages < npages)
+      continue;
+    if(s->npages > npages){
+      rest = (struct slab*)((char*)s + npages * PGSIZE);
+      rest->magic = BIGMAGIC;
+      rest->npages = s->npages - npages;
+      rest->next = s->next;
+      *pp = rest;
+      s->npages = npages;
+    } else
+      *pp = s->next;
+    mutex_unlock(&heaplock);
+    return s + 1;
+  }
+  if((s = morepages(npages)) != 0){
+    s->magic = BIGMAGIC;
+    s->npages = npages;
+  }
+  mutex_unlock(&heaplock);
+  return s ? s + 1 : 0;
+}
+
+static void
+bigrelease(struct slab *s)
+{
+  struct slab *p, **pp;
+
+  mutex_lock(&heaplock);
+  p = 0;
+  for(pp = &bigfree; *pp && *pp < s; pp = &(*pp)->next)
+    p = *pp;
+  s->next = *pp;
+  *pp = s;
+  if(s->next && (char*)s + s->npages * PGSIZE == (char*)s->next){
+    s->npages += s->next->npages;
+    s->next = s->next->next;
+  }
+  if(p && (char*)p + p->npages * PGSIZE == (char*)s){
+    p->npages += s->npages;
+    p->next = s->next;
+  }
+  mutex_unlock(&heaplock);
 }
 
 void*
 malloc(uint nbytes)
 {
-  Header *p, *prevp;
-  uint nunits;
+  struct tcache *tc;
+  struct object *o;
+  int c;
 
-  nunits = (nbytes + sizeof(Header) - 1)/sizeof(Header) + 1;
-  if((prevp = freep) == 0){
-    base.s.ptr = freep = prevp = &base;
-    base.s.size = 0;
+  if(nbytes > MAXSMALL)
+    return bigalloc(nbytes);
+  c = sizeclass(nbytes);
+  if((tc = mycache()) == 0)
+    return depotget(c, &o, 1) ? o : 0;
+  if(tc->head[c] == 0){
+    if((tc->count[c] = depotget(c, &tc->head[c], BATCH)) == 0)
+      return 0;
   }
-  for(p = prevp->s.ptr; ; prevp = p, p = p->s.ptr){
-    if(p->s.size >= nunits){
-      if(p->s.size == nunits)
-        prevp->s.ptr = p->s.ptr;
-      else {
-        p->s.size -= nunits;
-        p += p->s.size;
-        p->s.size = nunits;
-      }
-      freep = prevp;
-      return (void*)(p + 1);
+  o = tc->head[c];
+  tc->head[c] = o->next;
+  tc->count[c]--;
+  return o;
+}
+
+void
+free(void *ap)
+{
+  struct slab *s;
+  struct tcache *tc;
+  struct object *o, *tail;
+  int c, n;
+
+  if(ap == 0)
+    return;
+  s = (struct slab*)((uint)ap & ~(PGSIZE - 1));
+  if(s->magic == BIGMAGIC){
+    bigrelease(s);
+    return;
+  }
+  c = s->class;
+  o = ap;
+  if((tc = mycache()) == 0){
+    depotput(c, o, o);
+    return;
+  }
+  o->next = tc->head[c];
+  tc->head[c] = o;
+  // Keep BATCH objects and hand the rest back, so that memory freed
+  // by one thread can be reused by the others.
+  if(++tc->count[c] > 2 * BATCH){
+    for(tail = o, n = 1; n < tc->count[c] - BATCH; n++)
+      tail = tail->next;
+    tc->head[c] = tail->next;
+    depotput(c, o, tail);
+    tc->count[c] = BATCH;
+  }
+}
+
+// Hand the calling thread's cache back to the depot before the thread
+// goes away, then exit it. This is the thread_exit() of user.h, with
+// the same interface as the system call it wraps.
+void
+thread_exit(void *retval)
+{
+  struct tls *t = tls();
+  struct tcache *tc;
+  struct object *tail;
+  int c;
+
+  if((tc = t->slot[TLS_MALLOC]) != 0){
+    t->slot[TLS_MALLOC] = 0;
+    for(c = 0; c < NCLASS; c++){
+      if(tc->head[c] == 0)
+        continue;
+      for(tail = tc->head[c]; tail->next; tail = tail->next)
+        ;
+      depotput(c, tc->head[c], tail);
     }
-    if(p == freep)
-      if((p = morecore(nunits)) == 0)
-        return 0;
+    tail = (struct object*)tc;
+    depotput(sizeclass(sizeof(struct tcache)), tail, tail);
   }
+  _thread_exit(retval);
 }
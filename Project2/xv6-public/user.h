@@ -1,4 +1,5 @@
 struct stat;
+struct pstat;
 struct rtcdate;
 
 // system calls
@@ -28,6 +29,10 @@ int setmemorylimit(int, int);
 int thread_create(thread_t*, void*(*)(void*), void*);
 void thread_exit(void*);
 int thread_join(thread_t, void**);
+int futex_wait(int*, int);
+int futex_wake(int*, int);
+int setmemorysoftlimit(int, int);
+int procinfo(struct pstat*, int);
 
 // ulib.c
 int stat(const char*, struct stat*);
@@ -42,4 +47,77 @@ void* memset(void*, int, uint);
 void* malloc(uint);
 void free(void*);
 int atoi(const char*);
-void list_info(void);
\ No newline at end of file
+void list_info(void);
+
+// ulib.c: thread synchronization on top of futex_wait/futex_wake.
+// Zero-filled structs are unlocked mutexes and condvars with no waiters.
+typedef struct {
+  volatile int state;   // 0 unlocked, 1 locked, 2 locked with waiters
+} mutex_t;
+
+typedef struct {
+  volatile int seq;     // bumped by every signal and broadcast
+} cond_t;
+
+typedef struct {
+  mutex_t lock;
+  cond_t cond;
+  int n;                // threads to wait for
+  int count;            // threads waiting now
+  int gen;              // bumped each time the barrier opens
+} barrier_t;
+
+void mutex_lock(mutex_t*);
+void mutex_unlock(mutex_t*);
+void cond_wait(cond_t*, mutex_t*);
+void cond_signal(cond_t*);
+void cond_broadcast(cond_t*);
+void barrier_init(barrier_t*, int);
+void barrier_wait(barrier_t*);
+
+// ulib.c: thread-local storage. Every thread, the main one included,
+// has its own block of TLSSIZE (param.h) bytes, which the kernel fills
+// as below when the thread starts and %gs addresses.
+#define TLS_NSLOT 30    // TLSSIZE/4 - 2
+#define TLS_MALLOC (TLS_NSLOT - 1) // slot used by malloc for the thread's cache
+
+struct tls {
+  struct tls *self;     // this block's address, read through %gs:0
+  thread_t tid;         // the thread's tid
+  void *slot[TLS_NSLOT]; // zero at start, free for the thread's use
+};
+
+struct tls* tls(void);
+
+// tpool.c: a fixed set of worker threads running tasks from a bounded
+// lock-free queue. A future_t receives one task's result.
+#define TPOOL_MAXWORKER 16
+#define TPOOL_QSIZE     64    // power of two
+
+typedef struct {
+  volatile int state;   // 0 pending, 1 done, 2 pending with a waiter
+  void *result;
+} future_t;
+
+struct tpool_cell {
+  volatile uint seq;    // which lap of the ring this cell is ready for
+  void *(*fn)(void*);
+  void *arg;
+  future_t *future;
+};
+
+typedef struct {
+  struct tpool_cell cell[TPOOL_QSIZE];
+  volatile uint head;   // next cell to take a task from
+  volatile uint tail;   // next cell to put a task in
+  volatile int pending; // tasks queued; idle workers sleep on it
+  volatile int idle;    // workers asleep or about to be
+  volatile int stop;
+  int nworker;
+  thread_t worker[TPOOL_MAXWORKER];
+} tpool_t;
+
+int tpool_init(tpool_t*, int);
+int tpool_submit(tpool_t*, void*(*)(void*), void*, future_t*);
+void tpool_destroy(tpool_t*);
+void* future_get(future_t*);
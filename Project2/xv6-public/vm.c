@@ -5,10 +5,12 @@
 #include "memlayout.h"
 #include "mmu.h"
 #include "proc.h"
+#include "spinlock.h"
 #include "elf.h"
 
 extern char data[];  // defined by kernel.ld
 pde_t *kpgdir;  // for use in scheduler()
+static struct spinlock cowlock;  // copy-on-write changes to user page tables
 
 // Set up CPU's kernel segment descriptors.
 // Run once on entry on each CPU.
@@ -140,6 +142,7 @@ setupkvm(void)
 void
 kvmalloc(void)
 {
+  initlock(&cowlock, "cow");
   kpgdir = setupkvm();
   switchkvm();
 }
@@ -152,15 +155,18 @@ switchkvm(void)
   lcr3(V2P(kpgdir));   // switch to the kernel page table
 }
 
-// Switch TSS and h/w page table to correspond to process p.
+// Switch TSS and h/w page table to correspond to thread t:
+// its own kernel stack and its process's page table. SEG_UTLS is
+// pointed at t's TLS block; the user %gs picks it up when trapret
+// reloads it.
 void
-switchuvm(struct proc *p)
+switchuvm(struct thread *t)
 {
-  if(p == 0)
-    panic("switchuvm: no process");
-  if(p->kstack == 0)
+  if(t == 0)
+    panic("switchuvm: no thread");
+  if(t->kstack == 0)
     panic("switchuvm: no kstack");
-  if(p->pgdir == 0)
+  if(t->proc->pgdir == 0)
     panic("switchuvm: no pgdir");
 
   pushcli();
@@ -168,15 +174,30 @@ switchuvm(struct proc *p)
                                 sizeof(mycpu()->ts)-1, 0);
   mycpu()->gdt[SEG_TSS].s = 0;
   mycpu()->ts.ss0 = SEG_KDATA << 3;
-  mycpu()->ts.esp0 = (uint)p->kstack + KSTACKSIZE;
+  mycpu()->ts.esp0 = (uint)t->kstack + KSTACKSIZE;
   // setting IOPL=0 in eflags *and* iomb beyond the tss segment limit
   // forbids I/O instructions (e.g., inb and outb) from user space
   mycpu()->ts.iomb = (ushort) 0xFFFF;
   ltr(SEG_TSS << 3);
-  lcr3(V2P(p->pgdir));  // switch to process's address space
+  mycpu()->gdt[SEG_UTLS] = SEG16(STA_W, t->tls, TLSSIZE-1, DPL_USER);
+  lcr3(V2P(t->proc->pgdir));  // switch to process's address space
   popcli();
 }
 
+// Fill the TLS block at user address tls in pgdir: a pointer to the
+// block itself, so that user code can find it through %gs:0, then the
+// thread's tid, then zeros. Returns -1 if the block is not mapped.
+int
+tlsinit(pde_t *pgdir, uint tls, uint tid)
+{
+  uint block[TLSSIZE/4];
+
+  memset(block, 0, sizeof(block));
+  block[0] = tls;
+  block[1] = tid;
+  return copyout(pgdir, tls, block, sizeof(block));
+}
+
 // Load the initcode into address 0 of pgdir.
 // sz must be less than a page.
 void
@@ -254,13 +275,40 @@ allocuvm(pde_t *pgdir, uint oldsz, uint newsz)
 // process size.  Returns the new process size.
 int
 deallocuvm(pde_t *pgdir, uint oldsz, uint newsz)
+{
+  char *freed, *v;
+
+  if(newsz >= oldsz)
+    return oldsz;
+  freed = 0;
+  unmapuvm(pgdir, oldsz, newsz, &freed);
+  while((v = freed) != 0){
+    freed = *(char**)v;
+    kfree(v);
+  }
+  return newsz;
+}
+
+// Like deallocuvm, but the unmapped pages are not freed: each is
+// pushed onto the list *freed, linked through its first word, so
+// that a caller whose other threads may still hold TLB entries for
+// them can free them after tlbshootdown().
+// The entries are cleared under cowlock, so that a fork by another
+// thread (see copyuvm) either shares a page before it is unmapped,
+// taking its own reference, or does not see it at all.
+// Returns the number of pages unmapped.
+int
+unmapuvm(pde_t *pgdir, uint oldsz, uint newsz, char **freed)
 {
   pte_t *pte;
   uint a, pa;
+  int n;
 
+  n = 0;
   if(newsz >= oldsz)
-    return oldsz;
+    return 0;
 
+  acquire(&cowlock);
   a = PGROUNDUP(newsz);
   for(; a  < oldsz; a += PGSIZE){
     pte = walkpgdir(pgdir, (char*)a, 0);
@@ -271,11 +319,57 @@ deallocuvm(pde_t *pgdir, uint oldsz, uint newsz)
       if(pa == 0)
         panic("kfree");
       char *v = P2V(pa);
-      kfree(v);
+      *(char**)v = *freed;
+      *freed = v;
       *pte = 0;
+      n++;
     }
   }
-  return newsz;
+  release(&cowlock);
+  return n;
+}
+
+// Count the pages of physical memory that pgdir holds for user
+// space: the page directory, its user page tables and the mapped
+// user pages. This walks the whole table; a running process keeps
+// the count in p->rss instead.
+uint
+uvmpages(pde_t *pgdir)
+{
+  pte_t *pgtab;
+  uint i, j, n;
+
+  n = 1;
+  for(i = 0; i < PDX(KERNBASE); i++){
+    if(!(pgdir[i] & PTE_P))
+      continue;
+    n++;
+    pgtab = (pte_t*)P2V(PTE_ADDR(pgdir[i]));
+    for(j = 0; j < NPTENTRIES; j++)
+      if(pgtab[j] & PTE_P)
+        n++;
+  }
+  return n;
+}
+
+// Count the pages allocuvm(pgdir, oldsz, newsz) would allocate,
+// page tables included.
+uint
+uvmgrowth(pde_t *pgdir, uint oldsz, uint newsz)
+{
+  uint a, n, pdx;
+
+  n = 0;
+  pdx = NPDENTRIES;
+  for(a = PGROUNDUP(oldsz); a < newsz; a += PGSIZE){
+    if(PDX(a) != pdx){
+      pdx = PDX(a);
+      if(!(pgdir[pdx] & PTE_P))
+        n++;
+    }
+    n++;
+  }
+  return n;
 }
 
 // Free a page table and all the physical memory pages
@@ -311,7 +405,9 @@ clearpteu(pde_t *pgdir, char *uva)
 }
 
 // Given a parent process's page table, create a copy
-// of it for a child.
+// of it for a child. User pages are shared copy-on-write,
+// which takes write access away in the parent's page table
+// too, so the caller must flush the parent's TLB.
 // 부모 프로세스의 페이지테이블을 받아서, 자식프로세스의 페이지 테이블로 복사하는작업.
 pde_t*
 copyuvm(pde_t *pgdir, uint sz)
@@ -323,13 +419,27 @@ copyuvm(pde_t *pgdir, uint sz)
 
   if((d = setupkvm()) == 0)
     return 0;
+  // Other threads of the parent may be splitting pages meanwhile.
+  acquire(&cowlock);
   for(i = 0; i < sz; i += PGSIZE){
-    if((pte = walkpgdir(pgdir, (void *) i, 0)) == 0)
-      panic("copyuvm: pte should exist");
-    if(!(*pte & PTE_P))
-      panic("copyuvm: page not present");
+    // Heap that was never touched (see lazyfault) and stacks
+    // reclaimed from the thread stack pool are not mapped.
+    if((pte = walkpgdir(pgdir, (void *) i, 0)) == 0 || !(*pte & PTE_P))
+      continue;
     pa = PTE_ADDR(*pte);
     flags = PTE_FLAGS(*pte);
+    // Share the pages the user can write: both page tables map them
+    // read-only, and whichever side writes first gets its own copy
+    // (see cowfault). Others, like the guard page below the stack,
+    // are copied now.
+    if((flags & PTE_U) && (flags & (PTE_W|PTE_COW))){
+      flags = (flags & ~PTE_W) | PTE_COW;
+      *pte = pa | flags;
+      if(mappages(d, (void*)i, PGSIZE, pa, flags) < 0)
+        goto bad;
+      kincref(P2V(pa));
+      continue;
+    }
     if((mem = kalloc()) == 0)
       goto bad;
     memmove(mem, (char*)P2V(pa), PGSIZE);
@@ -338,13 +448,91 @@ copyuvm(pde_t *pgdir, uint sz)
       goto bad;
     }
   }
+  release(&cowlock);
   return d;
 
 bad:
+  release(&cowlock);
   freevm(d);
   return 0;
 }
 
+// Handle a write to the copy-on-write page at va in pgdir: if
+// another page table still shares the page, give pgdir a copy of
+// its own, then make it writable. Returns -1 if va is not such a
+// page or there is no memory for the copy.
+// Threads of a process fault on the same page table at once, so
+// the change is made under cowlock, and the other cpus running them
+// are made to drop the old entry before the write is retried (see cowflush).
+int
+cowfault(pde_t *pgdir, uint va)
+{
+  pte_t *pte;
+  uint pa, flags;
+  char *mem;
+  int r;
+
+  if(va >= KERNBASE)
+    return -1;
+  acquire(&cowlock);
+  r = -1;
+  if((pte = walkpgdir(pgdir, (char*)va, 0)) == 0)
+    goto out;
+  if((*pte & (PTE_P|PTE_U|PTE_W)) == (PTE_P|PTE_U|PTE_W)){
+    // Another thread got here first; this cpu had the old entry.
+    r = 0;
+    goto out;
+  }
+  if((*pte & (PTE_P|PTE_U|PTE_COW)) != (PTE_P|PTE_U|PTE_COW))
+    goto out;
+  pa = PTE_ADDR(*pte);
+  flags = (PTE_FLAGS(*pte) | PTE_W) & ~PTE_COW;
+  if(krefcount(P2V(pa)) > 1){
+    if((mem = kalloc()) == 0)
+      goto out;
+    memmove(mem, (char*)P2V(pa), PGSIZE);
+    *pte = V2P(mem) | flags;
+    kfree((char*)P2V(pa));
+  } else
+    *pte = pa | flags;
+  r = 0;
+out:
+  release(&cowlock);
+  if(r == 0){
+    if(rcr3() == V2P(pgdir))
+      lcr3(V2P(pgdir));
+    if(myproc() && myproc()->pgdir == pgdir)
+      cowflush(myproc());
+  }
+  return r;
+}
+
+// Map a zeroed page at va in pgdir, for a fault on heap that sbrk
+// made room for but nothing has touched yet (see growproc). A page
+// that is mapped already is left alone. Returns 1 if a page was
+// mapped, 0 if one was there already, and -1 if va is not below sz
+// or there is no memory.
+int
+lazyfault(pde_t *pgdir, uint sz, uint va)
+{
+  pte_t *pte;
+  char *mem;
+
+  if(va >= sz || va >= KERNBASE)
+    return -1;
+  va = PGROUNDDOWN(va);
+  if((pte = walkpgdir(pgdir, (char*)va, 0)) != 0 && (*pte & PTE_P))
+    return 0;
+  if((mem = kalloc()) == 0)
+    return -1;
+  memset(mem, 0, PGSIZE);
+  if(mappages(pgdir, (char*)va, PGSIZE, V2P(mem), PTE_W|PTE_U) < 0){
+    kfree(mem);
+    return -1;
+  }
+  return 1;
+}
+
 //PAGEBREAK!
 // Map user virtual address to kernel address.
 char*
@@ -353,7 +541,7 @@ uva2ka(pde_t *pgdir, char *uva)
   pte_t *pte;
 
   pte = walkpgdir(pgdir, uva, 0);
-  if((*pte & PTE_P) == 0)
+  if(pte == 0 || (*pte & PTE_P) == 0)
     return 0;
   if((*pte & PTE_U) == 0)
     return 0;
@@ -368,6 +556,7 @@ copyout(pde_t *pgdir, uint va, void *p, uint len)
 {
   char *buf, *pa0;
   uint n, va0;
+  pte_t *pte;
 
   buf = (char*)p;
   while(len > 0){
@@ -375,6 +564,14 @@ copyout(pde_t *pgdir, uint va, void *p, uint len)
     pa0 = uva2ka(pgdir, (char*)va0);
     if(pa0 == 0)
       return -1;
+    // The kernel writes through its own mapping, which does not
+    // fault on a copy-on-write page, so split it first.
+    pte = walkpgdir(pgdir, (char*)va0, 0);
+    if(*pte & PTE_COW){
+      if(cowfault(pgdir, va0) < 0)
+        return -1;
+      pa0 = uva2ka(pgdir, (char*)va0);
+    }
     n = PGSIZE - (va - va0);
     if(n > len)
       n = len;
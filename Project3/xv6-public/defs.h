@@ -68,6 +68,8 @@ char*           kalloc(void);
 void            kfree(char*);
 void            kinit1(void*, void*);
 void            kinit2(void*, void*);
+void            kincref(char*);
+int             krefcount(char*);
 
 // kbd.c
 void            kbdintr(void);
@@ -181,6 +183,9 @@ void            freevm(pde_t*);
 void            inituvm(pde_t*, char*, uint);
 int             loaduvm(pde_t*, char*, struct inode*, uint, uint);
 pde_t*          copyuvm(pde_t*, uint);
+int             cowfault(pde_t*, uint);
+int             lazyfault(pde_t*, uint, uint);
+int             uvmtouch(pde_t*, uint, uint, uint);
 void            switchuvm(struct proc*);
 void            switchkvm(void);
 int             copyout(pde_t*, uint, void*, uint);
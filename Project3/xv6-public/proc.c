@@ -163,8 +163,10 @@ growproc(int n)
 
   sz = curproc->sz;
   if(n > 0){
-    if((sz = allocuvm(curproc->pgdir, sz, sz + n)) == 0)
+    // Pages are allocated when first touched (see lazyfault).
+    if(sz + n < sz || sz + n >= KERNBASE)
       return -1;
+    sz += n;
   } else if(n < 0){
     if((sz = deallocuvm(curproc->pgdir, sz, sz + n)) == 0)
       return -1;
@@ -196,6 +198,8 @@ fork(void)
     np->state = UNUSED;
     return -1;
   }
+  // copyuvm made the parent's pages read-only; drop the writable TLB entries.
+  lcr3(V2P(curproc->pgdir));
   np->sz = curproc->sz;
   np->parent = curproc;
   *np->tf = *curproc->tf;
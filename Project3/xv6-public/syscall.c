@@ -13,6 +13,21 @@
 // library system call function. The saved user %esp points
 // to a saved program counter, and then the first argument.
 
+// Fault in n bytes at addr of the current process, which the caller
+// has checked, before the kernel uses them. Kills the process if there
+// is no memory for them.
+static int
+touch(uint addr, uint n)
+{
+  struct proc *curproc = myproc();
+
+  if(uvmtouch(curproc->pgdir, curproc->sz, addr, n) < 0){
+    curproc->killed = 1;
+    return -1;
+  }
+  return 0;
+}
+
 // Fetch the int at addr from the current process.
 int
 fetchint(uint addr, int *ip)
@@ -21,6 +36,8 @@ fetchint(uint addr, int *ip)
 
   if(addr >= curproc->sz || addr+4 > curproc->sz)
     return -1;
+  if(touch(addr, 4) < 0)
+    return -1;
   *ip = *(int*)(addr);
   return 0;
 }
@@ -39,6 +56,8 @@ fetchstr(uint addr, char **pp)
   *pp = (char*)addr;
   ep = (char*)curproc->sz;
   for(s = *pp; s < ep; s++){
+    if((s == *pp || (uint)s % PGSIZE == 0) && touch((uint)s, 1) < 0)
+      return -1;
     if(*s == 0)
       return s - *pp;
   }
@@ -65,6 +84,8 @@ argptr(int n, char **pp, int size)
     return -1;
   if(size < 0 || (uint)i >= curproc->sz || (uint)i+size > curproc->sz)
     return -1;
+  if(touch(i, size) < 0)
+    return -1;
   *pp = (char*)i;
   return 0;
 }
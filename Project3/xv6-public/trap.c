@@ -77,6 +77,17 @@ trap(struct trapframe *tf)
             cpuid(), tf->cs, tf->eip);
     lapiceoi();
     break;
+  case T_PGFLT:
+    // Heap that sbrk made room for but nothing has touched yet (see
+    // lazyfault), or a write to a page shared copy-on-write since fork
+    // (see copyuvm). System calls fault in the user memory they use
+    // beforehand (see argptr), so in the kernel it is the latter.
+    if(myproc() && !(tf->err & 1) &&
+       lazyfault(myproc()->pgdir, myproc()->sz, rcr2()) == 0)
+      break;
+    if(myproc() && (tf->err & 2) && cowfault(myproc()->pgdir, rcr2()) == 0)
+      break;
+    // fall through
 
   //PAGEBREAK: 13
   default:
@@ -311,7 +311,9 @@ clearpteu(pde_t *pgdir, char *uva)
 }
 
 // Given a parent process's page table, create a copy
-// of it for a child.
+// of it for a child. User pages are shared copy-on-write,
+// which takes write access away in the parent's page table
+// too, so the caller must flush the parent's TLB.
 pde_t*
 copyuvm(pde_t *pgdir, uint sz)
 {
@@ -323,12 +325,23 @@ copyuvm(pde_t *pgdir, uint sz)
   if((d = setupkvm()) == 0)
     return 0;
   for(i = 0; i < sz; i += PGSIZE){
-    if((pte = walkpgdir(pgdir, (void *) i, 0)) == 0)
-      panic("copyuvm: pte should exist");
-    if(!(*pte & PTE_P))
-      panic("copyuvm: page not present");
+    // Heap that was never touched is not mapped (see lazyfault).
+    if((pte = walkpgdir(pgdir, (void *) i, 0)) == 0 || !(*pte & PTE_P))
+      continue;
     pa = PTE_ADDR(*pte);
     flags = PTE_FLAGS(*pte);
+    // Share the pages the user can write: both page tables map them
+    // read-only, and whichever side writes first gets its own copy
+    // (see cowfault). Others, like the guard page below the stack,
+    // are copied now.
+    if((flags & PTE_U) && (flags & (PTE_W|PTE_COW))){
+      flags = (flags & ~PTE_W) | PTE_COW;
+      *pte = pa | flags;
+      if(mappages(d, (void*)i, PGSIZE, pa, flags) < 0)
+        goto bad;
+      kincref(P2V(pa));
+      continue;
+    }
     if((mem = kalloc()) == 0)
       goto bad;
     memmove(mem, (char*)P2V(pa), PGSIZE);
@@ -344,6 +357,77 @@ bad:
   return 0;
 }
 
+// Handle a write to the copy-on-write page at va in pgdir: if
+// another page table still shares the page, give pgdir a copy of
+// its own, then make it writable. Returns -1 if va is not such a
+// page or there is no memory for the copy.
+int
+cowfault(pde_t *pgdir, uint va)
+{
+  pte_t *pte;
+  uint pa, flags;
+  char *mem;
+
+  if(va >= KERNBASE || (pte = walkpgdir(pgdir, (char*)va, 0)) == 0)
+    return -1;
+  if((*pte & (PTE_P|PTE_U|PTE_COW)) != (PTE_P|PTE_U|PTE_COW))
+    return -1;
+  pa = PTE_ADDR(*pte);
+  flags = (PTE_FLAGS(*pte) | PTE_W) & ~PTE_COW;
+  if(krefcount(P2V(pa)) > 1){
+    if((mem = kalloc()) == 0)
+      return -1;
+    memmove(mem, (char*)P2V(pa), PGSIZE);
+    *pte = V2P(mem) | flags;
+    kfree((char*)P2V(pa));
+  } else
+    *pte = pa | flags;
+  if(rcr3() == V2P(pgdir))
+    lcr3(V2P(pgdir));
+  return 0;
+}
+
+// Map a zeroed page at va in pgdir, for a fault on heap that sbrk
+// made room for but nothing has touched yet (see growproc). A page
+// that is mapped already is left alone. Returns -1 if va is not below
+// sz or there is no memory.
+int
+lazyfault(pde_t *pgdir, uint sz, uint va)
+{
+  pte_t *pte;
+  char *mem;
+
+  if(va >= sz || va >= KERNBASE)
+    return -1;
+  va = PGROUNDDOWN(va);
+  if((pte = walkpgdir(pgdir, (char*)va, 0)) != 0 && (*pte & PTE_P))
+    return 0;
+  if((mem = kalloc()) == 0)
+    return -1;
+  memset(mem, 0, PGSIZE);
+  if(mappages(pgdir, (char*)va, PGSIZE, V2P(mem), PTE_W|PTE_U) < 0){
+    kfree(mem);
+    return -1;
+  }
+  return 0;
+}
+
+// Fault in the pages of [va, va+n) in pgdir that nothing has touched
+// yet (see lazyfault), so that a system call can use the range directly
+// rather than fault on it in the kernel, where running out of memory
+// cannot be handled. The range must be below sz. Returns -1 if there is
+// no memory.
+int
+uvmtouch(pde_t *pgdir, uint sz, uint va, uint n)
+{
+  uint a;
+
+  for(a = PGROUNDDOWN(va); a < va + n; a += PGSIZE)
+    if(lazyfault(pgdir, sz, a) < 0)
+      return -1;
+  return 0;
+}
+
 //PAGEBREAK!
 // Map user virtual address to kernel address.
 char*
@@ -352,7 +436,7 @@ uva2ka(pde_t *pgdir, char *uva)
   pte_t *pte;
 
   pte = walkpgdir(pgdir, uva, 0);
-  if((*pte & PTE_P) == 0)
+  if(pte == 0 || (*pte & PTE_P) == 0)
     return 0;
   if((*pte & PTE_U) == 0)
     return 0;
@@ -367,6 +451,7 @@ copyout(pde_t *pgdir, uint va, void *p, uint len)
 {
   char *buf, *pa0;
   uint n, va0;
+  pte_t *pte;
 
   buf = (char*)p;
   while(len > 0){
@@ -374,6 +459,14 @@ copyout(pde_t *pgdir, uint va, void *p, uint len)
     pa0 = uva2ka(pgdir, (char*)va0);
     if(pa0 == 0)
       return -1;
+    // The kernel writes through its own mapping, which does not
+    // fault on a copy-on-write page, so split it first.
+    pte = walkpgdir(pgdir, (char*)va0, 0);
+    if(*pte & PTE_COW){
+      if(cowfault(pgdir, va0) < 0)
+        return -1;
+      pa0 = uva2ka(pgdir, (char*)va0);
+    }
     n = PGSIZE - (va - va0);
     if(n > len)
       n = len;